@@ -0,0 +1,99 @@
+#include <chrono>
+
+#include <iostream>
+
+#include "sqliteutils.hpp"
+
+// rows per second inserted one rexec() at a time and with batch_inserter
+// for K = 1 .. 512, into a narrow and a wider table, to find the crossover
+constexpr int rows(1 << 20);
+
+template <typename F>
+static double rate(sqlite3* const db, F const f)
+{
+  squ::execmulti(db, std::string("DELETE FROM n; DELETE FROM w; BEGIN"));
+
+  auto const b(std::chrono::steady_clock::now());
+
+  f();
+
+  squ::execmulti(db, std::string("COMMIT"));
+
+  return rows / std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - b).count();
+}
+
+template <std::size_t K>
+static void run(sqlite3* const db)
+{
+  auto const n(rate(db, [db]()
+    {
+      squ::batch_inserter<K, sqlite3_int64> b(db, "INSERT INTO n(a)");
+
+      for (int i{}; i != rows; ++i)
+      {
+        b.insert(i);
+      }
+    }
+  ));
+
+  auto const w(rate(db, [db]()
+    {
+      squ::batch_inserter<K, sqlite3_int64, double, std::string_view,
+        sqlite3_int64> b(db, "INSERT INTO w(a, b, c, d)");
+
+      for (int i{}; i != rows; ++i)
+      {
+        b.insert(i, i * .5, "text", -i);
+      }
+    }
+  ));
+
+  std::cout << "K " << K << ": narrow " << n << " rows/s, wide " << w <<
+    " rows/s" << std::endl;
+}
+
+template <std::size_t ...J>
+static void run_all(sqlite3* const db, std::index_sequence<J...>)
+{
+  (run<std::size_t(1) << J>(db), ...);
+}
+
+int main()
+{
+  auto const db(squ::open_unique(":memory:",
+    SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE));
+
+  squ::execmulti(db, std::string("CREATE TABLE n(a INTEGER);"
+    "CREATE TABLE w(a INTEGER, b REAL, c TEXT, d INTEGER)"));
+
+  auto const sn(squ::make_unique(db, "INSERT INTO n(a) VALUES(?)"));
+  auto const sw(squ::make_unique(db,
+    "INSERT INTO w(a, b, c, d) VALUES(?, ?, ?, ?)"));
+
+  auto const n(rate(db.get(), [&]()
+    {
+      for (int i{}; i != rows; ++i)
+      {
+        squ::rexec(sn, sqlite3_int64(i));
+      }
+    }
+  ));
+
+  auto const w(rate(db.get(), [&]()
+    {
+      for (int i{}; i != rows; ++i)
+      {
+        squ::rexec(sw, sqlite3_int64(i), i * .5, std::string_view("text"),
+          sqlite3_int64(-i));
+      }
+    }
+  ));
+
+  std::cout << "rexec: narrow " << n << " rows/s, wide " << w << " rows/s" <<
+    std::endl;
+
+  run_all(db.get(), std::make_index_sequence<10>());
+
+  return 0;
+}
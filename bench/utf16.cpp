@@ -0,0 +1,73 @@
+#include <chrono>
+
+#include <iostream>
+
+#include <vector>
+
+#include "sqliteutils.hpp"
+
+// decode a text column as UTF-16 with get_utf16() and with
+// sqlite3_column_text16(), which converts and caches a copy in the column
+template <typename F>
+static double ns_per_row(sqlite3_stmt* const s, int const n, F const f)
+{
+  auto const b(std::chrono::steady_clock::now());
+
+  for (auto i(n); i; --i)
+  {
+    sqlite3_step(s);
+    f();
+    sqlite3_reset(s);
+  }
+
+  return std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - b).count() / n;
+}
+
+int main()
+{
+  auto const db(squ::open_unique(":memory:",
+    SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE));
+  auto const s(squ::make_unique(db, "SELECT ?"));
+
+  std::vector<char16_t> q;
+  std::size_t sink{};
+
+  for (auto const ascii: {true, false})
+  {
+    for (std::size_t const n: {16, 256, 4096, 65536})
+    {
+      std::string t;
+
+      for (std::size_t i{}; i != n; ++i)
+      {
+        // one two-byte sequence every 8 characters
+        ascii || (i % 8) ? t.push_back(char('a' + i % 26)) : void(t += "é");
+      }
+
+      squ::set(s, t);
+      q.resize(t.size());
+
+      auto const k(int(std::max(std::size_t(1) << 24, n) / n));
+
+      auto const a(ns_per_row(s.get(), k, [&]() noexcept
+        {
+          sink += squ::get_utf16(s, 0, q.data(), q.size()).second;
+        }
+      ));
+
+      auto const c(ns_per_row(s.get(), k, [&]() noexcept
+        {
+          sqlite3_column_text16(s.get(), 0);
+          sink += std::size_t(sqlite3_column_bytes16(s.get(), 0));
+        }
+      ));
+
+      std::cout << (ascii ? "ascii " : "mixed ") << t.size() << " bytes: "
+        << "get_utf16 " << a << " ns, column_text16 " << c << " ns"
+        << std::endl;
+    }
+  }
+
+  return !sink;
+}
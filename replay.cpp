@@ -0,0 +1,64 @@
+#include <cstdlib>
+
+#include <cstring>
+
+#include <iostream>
+
+#include "sqliteutils.hpp"
+
+// replay a log written by squ::recorder against a copy of the database
+int main(int argc, char* argv[])
+{
+  squ::replay_options o;
+
+  // -c n replays every recorded connection n times at once
+  auto const name(argv[0]);
+
+  if ((argc > 2) && !std::strcmp(argv[1], "-c"))
+  {
+    o.copies = unsigned(std::strtoul(argv[2], nullptr, 10));
+
+    argc -= 2;
+    argv += 2;
+  }
+
+  if ((argc < 3) || (argc > 5) || !o.copies)
+  {
+    std::cerr << "usage: " << name << " [-c copies] log db [paced [speed]]" << std::endl;
+
+    return 1;
+  }
+
+  o.paced = argc > 3;
+
+  if (argc > 4)
+  {
+    o.speed = std::strtod(argv[4], nullptr);
+  }
+
+  auto const r(squ::replay(argv[1], argv[2], o));
+
+  if (SQLITE_OK != r.result)
+  {
+    std::cerr << "replay failed: " << sqlite3_errstr(r.result) << std::endl;
+
+    return 1;
+  }
+
+  auto const s(std::chrono::duration<double>(r.elapsed).count());
+
+  std::cout << r.connections << " connections, " << r.statements << " statements, " << r.failures << " failures in " << s << " s, " << (s > 0 ? r.statements / s : 0) << " statements/s" << std::endl;
+
+  if (!r.latencies.empty())
+  {
+    auto const pct([&](double const p) noexcept
+      {
+        return r.latencies[std::size_t(p * (r.latencies.size() - 1))] / 1e3;
+      }
+    );
+
+    std::cout << "latency us: p50 " << pct(.5) << " p90 " << pct(.9) << " p99 " << pct(.99) << " max " << pct(1) << std::endl;
+  }
+
+  return 0;
+}
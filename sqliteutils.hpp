@@ -31,8 +31,40 @@
 
 #include <cassert>
 
+#include <cerrno>
+
+#include <cmath>
+
+#include <cstdint>
+
+#include <cstdio>
+
+#include <cstring>
+
+#include <algorithm>
+
+#include <array>
+
+#include <atomic>
+
+#include <charconv>
+
+#include <chrono>
+
+#include <condition_variable>
+
+#include <deque>
+
+#include <exception>
+
+#include <iterator>
+
+#include <limits>
+
 #include <memory>
 
+#include <mutex>
+
 #include <optional>
 
 #include <string>
@@ -41,8 +73,81 @@
 
 #include <type_traits>
 
+#include <unordered_map>
+
 #include <utility>
 
+#include <vector>
+
+// the heavier parts of the library are opt-in, define these before
+// including it to have them:
+//   SQU_ENABLE_THREADS: checkpointer, prefetch_rows, parallel_foreach_row
+//     and stmt_registry::warm, which run work on threads of their own
+//   SQU_ENABLE_IMPORT_CSV: import_csv
+//   SQU_ENABLE_RESULT_CACHE: result_cache
+//   SQU_ENABLE_CHANGE_STREAM: ring_buffer, change_stream
+//   SQU_ENABLE_RECORDER: recorder, replay
+//   SQU_ENABLE_COROUTINES: task and the async_ functions, with C++20
+//   SQU_ENABLE_SHARDED_DB: sharded_db
+// all but the first enable SQU_ENABLE_THREADS, SQU_NO_SIMD compiles the
+// transcoding without intrinsics
+#if defined(SQU_ENABLE_IMPORT_CSV) || defined(SQU_ENABLE_RECORDER) || \
+  defined(SQU_ENABLE_COROUTINES) || defined(SQU_ENABLE_SHARDED_DB) || \
+  defined(SQU_ENABLE_RESULT_CACHE) || defined(SQU_ENABLE_CHANGE_STREAM)
+# if !defined(SQU_ENABLE_THREADS)
+#  define SQU_ENABLE_THREADS
+# endif
+#endif
+
+#if defined(SQU_ENABLE_THREADS)
+# include <list>
+# include <thread>
+#endif
+
+#if defined(SQU_ENABLE_RESULT_CACHE)
+# include <any>
+# include <list>
+# include <unordered_set>
+#endif
+
+#if defined(SQU_ENABLE_CHANGE_STREAM)
+# include <list>
+#endif
+
+#if defined(SQU_ENABLE_CHANGE_STREAM) || \
+  (defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK))
+# include <variant>
+#endif
+
+#if defined(SQU_ENABLE_SHARDED_DB)
+# include <functional>
+# include <future>
+#endif
+
+#if __has_include(<unistd.h>)
+# include <unistd.h>
+#endif
+
+#if defined(SQU_ENABLE_COROUTINES) && defined(__cpp_impl_coroutine) && \
+  __has_include(<coroutine>)
+# include <coroutine>
+#endif
+
+#if __has_include(<span>)
+# include <span>
+#endif
+
+#if defined(SQU_NO_SIMD)
+#elif defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
 #include "sqlite3.h"
 
 namespace squ
@@ -156,6 +261,21 @@ inline auto set(sqlite3_stmt* const s, blobpair<TRANSIENT> const& v) noexcept
     sqlite3_bind_zeroblob64(s, I, v.second);
 }
 
+#if defined(__cpp_lib_span)
+// bound without a copy, the elements must outlive the binding
+template <int I, typename T, std::size_t N>
+inline std::enable_if_t<
+  std::is_trivially_copyable_v<T>,
+  decltype(sqlite3_bind_blob64({}, I, {}, {}, SQLITE_STATIC))
+>
+set(sqlite3_stmt* const s, std::span<T, N> const& v) noexcept
+{
+  return v.empty() ?
+    sqlite3_bind_zeroblob64(s, I, 0) :
+    sqlite3_bind_blob64(s, I, v.data(), v.size_bytes(), SQLITE_STATIC);
+}
+#endif // __cpp_lib_span
+
 //
 template <int I, typename T>
 inline std::enable_if_t<
@@ -228,7 +348,7 @@ inline auto set(sqlite3_stmt* const s,
 
 template <int I, enum encoding E>
 inline auto set(sqlite3_stmt* const s,
-  char16pair<TRANSIENT> const& v) noexcept
+  char16pair<TRANSIENT, E> const& v) noexcept
 {
   return sqlite3_bind_text64(s, I, reinterpret_cast<char const*>(v.first),
     v.second * sizeof(char16_t), SQLITE_TRANSIENT, E);
@@ -416,6 +536,97 @@ inline auto rset(S const& s, A&& ...args) noexcept(
   return rset<I>(s.get(), std::forward<A>(args)...);
 }
 
+//plan_check//////////////////////////////////////////////////////////////////
+enum plan_problem
+{
+  FULL_SCAN = 1,
+  TEMP_BTREE = 2
+};
+
+namespace detail
+{
+
+// FULL_SCAN | TEMP_BTREE flags for the query plan of s, uses only the C api,
+// as statements are checked as they are prepared
+inline int plan_problems(sqlite3_stmt* const s) noexcept
+{
+  auto const sql(sqlite3_sql(s));
+
+  if (!sql)
+  {
+    return 0;
+  }
+
+  // sqlite allocates the text, so that running out of memory throws nothing
+  std::unique_ptr<char, void (*)(void*)> const q(
+    sqlite3_mprintf("EXPLAIN QUERY PLAN %s", sql), &sqlite3_free);
+
+  sqlite3_stmt* e;
+
+  if (!q ||
+    (SQLITE_OK != sqlite3_prepare_v2(sqlite3_db_handle(s), q.get(), -1, &e,
+    nullptr)))
+  {
+    // e.g. the statement is an EXPLAIN itself
+    return 0;
+  }
+
+  int r{};
+
+  // id, parent, notused, detail
+  while (SQLITE_ROW == sqlite3_step(e))
+  {
+    std::string_view const d(
+      reinterpret_cast<char const*>(sqlite3_column_text(e, 3)),
+      std::size_t(sqlite3_column_bytes(e, 3))
+    );
+
+    if (!d.compare(0, 5, "SCAN ") &&
+      d.compare(5, std::string_view::npos, "CONSTANT ROW") &&
+      d.compare(5, 1, "(") &&
+      (std::string_view::npos == d.find(" VIRTUAL TABLE ")))
+    {
+      r |= FULL_SCAN;
+    }
+    else if (!d.compare(0, 19, "USE TEMP B-TREE FOR"))
+    {
+      r |= TEMP_BTREE;
+    }
+  }
+
+  sqlite3_finalize(e);
+
+  return r;
+}
+
+}
+
+#if defined(SQU_CHECK_PLANS)
+// called for statements make_unique and make_shared prepare with problems
+// in their plans, a test harness may substitute a reporter of its own
+using plan_reporter_t = void (*)(sqlite3_stmt*, int) noexcept;
+
+inline plan_reporter_t plan_reporter{
+  [](sqlite3_stmt*, int) noexcept
+  {
+    assert(!"statement does a full scan or uses a temp b-tree");
+  }
+};
+
+namespace detail
+{
+
+inline void check_plan(sqlite3_stmt* const s) noexcept
+{
+  if (auto const p(plan_problems(s)); p)
+  {
+    plan_reporter(s, p);
+  }
+}
+
+}
+#endif // SQU_CHECK_PLANS
+
 //make_unique/////////////////////////////////////////////////////////////////
 inline auto make_unique(sqlite3* const db, std::string_view const& sv,
   unsigned const fl = 0) noexcept
@@ -425,6 +636,13 @@ inline auto make_unique(sqlite3* const db, std::string_view const& sv,
   auto const r(sqlite3_prepare_v3(db, sv.data(), sv.size(), fl, &s, nullptr));
   assert(SQLITE_OK == r);
 
+#if defined(SQU_CHECK_PLANS)
+  if (SQLITE_OK == r && s)
+  {
+    detail::check_plan(s);
+  }
+#endif // SQU_CHECK_PLANS
+
   return SQLITE_OK == r ? unique_stmt_t(s) : unique_stmt_t();
 }
 
@@ -453,6 +671,13 @@ inline auto make_shared(sqlite3* const db, std::string_view const& sv,
   auto const r(sqlite3_prepare_v3(db, sv.data(), sv.size(), fl, &s, nullptr));
   assert(SQLITE_OK == r);
 
+#if defined(SQU_CHECK_PLANS)
+  if (SQLITE_OK == r && s)
+  {
+    detail::check_plan(s);
+  }
+#endif // SQU_CHECK_PLANS
+
   return SQLITE_OK == r ?
     shared_stmt_t(s, detail::sqlite3_stmt_deleter()) :
     shared_stmt_t();
@@ -577,6 +802,132 @@ inline auto execmulti(D const& db, A&& ...args) noexcept(
   return execmulti(db.get(), std::forward<A>(args)...);
 }
 
+//string_pool/////////////////////////////////////////////////////////////////
+// a concurrent pool of distinct strings, the views and ids it hands out stay
+// valid until it is cleared, strings are spread over shards by hash, each
+// with its own lock
+class string_pool
+{
+  static constexpr std::size_t shard_bits{4};
+
+  struct shard
+  {
+    mutable std::mutex m;
+
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+  };
+
+  std::array<shard, std::size_t(1) << shard_bits> shards_;
+
+public:
+  // the view and id of a copy of sv in the pool
+  std::pair<std::string_view, std::uint32_t> intern(std::string_view const sv)
+  {
+    auto const h(std::hash<std::string_view>()(sv) % shards_.size());
+
+    auto& s(shards_[h]);
+
+    std::lock_guard<std::mutex> l(s.m);
+
+    if (auto const i(s.ids.find(sv)); s.ids.end() != i)
+    {
+      return *i;
+    }
+    else
+    {
+      std::string_view const v(s.strings.emplace_back(sv));
+
+      return *s.ids.emplace(v,
+        std::uint32_t(((s.strings.size() - 1) << shard_bits) | h)).first;
+    }
+  }
+
+  std::string_view view(std::uint32_t const id) const noexcept
+  {
+    auto& s(shards_[id & ((1 << shard_bits) - 1)]);
+
+    std::lock_guard<std::mutex> l(s.m);
+
+    return s.strings[id >> shard_bits];
+  }
+
+  // number of distinct strings
+  std::size_t size() const noexcept
+  {
+    std::size_t n{};
+
+    for (auto& s: shards_)
+    {
+      std::lock_guard<std::mutex> l(s.m);
+      n += s.strings.size();
+    }
+
+    return n;
+  }
+
+  // drop every string, the pool keeps all it was given until then, so a
+  // long running process should clear it once no view or id of it is in use
+  void clear() noexcept
+  {
+    for (auto& s: shards_)
+    {
+      std::lock_guard<std::mutex> l(s.m);
+
+      s.ids.clear();
+      s.strings.clear();
+    }
+  }
+};
+
+namespace detail
+{
+
+template <typename Tag>
+inline string_pool tag_pool;
+
+}
+
+// a text column decoded into a string pool, that of its Tag unless another
+// is given, equal strings share one copy and id, NULL decodes to an empty
+// view and null_id
+template <typename Tag = void, string_pool& Pool = detail::tag_pool<Tag>>
+struct interned
+{
+  static constexpr std::uint32_t null_id{~std::uint32_t()};
+
+  static constexpr string_pool& pool{Pool};
+
+  std::string_view view;
+  std::uint32_t id{null_id};
+
+  operator std::string_view() const noexcept { return view; }
+
+  bool operator==(interned const& o) const noexcept { return id == o.id; }
+
+  bool operator!=(interned const& o) const noexcept { return id != o.id; }
+};
+
+namespace detail
+{
+
+template <typename>
+struct is_interned : std::false_type {};
+
+template <typename T, string_pool& P>
+struct is_interned<interned<T, P>> : std::true_type {};
+
+template <typename>
+struct is_const_span : std::false_type {};
+
+#if defined(__cpp_lib_span)
+template <typename T>
+struct is_const_span<std::span<T const>> :
+  std::bool_constant<std::is_trivially_copyable_v<T>> {};
+#endif // __cpp_lib_span
+
+}
+
 //get/////////////////////////////////////////////////////////////////////////
 template <typename T>
 inline std::enable_if_t<
@@ -687,6 +1038,69 @@ get(sqlite3_stmt* const s, int const i = 0) noexcept
   };
 }
 
+template <typename T>
+inline std::enable_if_t<
+  detail::is_interned<T>{},
+  T
+>
+get(sqlite3_stmt* const s, int const i = 0)
+{
+  if (auto const p(get<char const*>(s, i)); p)
+  {
+    auto const r(T::pool.intern({p, std::size_t(sqlite3_column_bytes(s, i))}));
+
+    return {r.first, r.second};
+  }
+  else
+  {
+    return {};
+  }
+}
+
+#if defined(__cpp_lib_span)
+// a view of a blob as an array of T, the blob must be aligned for T and its
+// size a multiple of sizeof(T), but sqlite aligns blobs only by chance, so
+// unless alignof(T) is 1 use get_span(), which copies misaligned blobs
+template <typename T>
+inline std::enable_if_t<
+  detail::is_const_span<T>{},
+  T
+>
+get(sqlite3_stmt* const s, int const i = 0) noexcept
+{
+  using E = typename T::element_type;
+
+  auto const p(sqlite3_column_blob(s, i));
+  std::size_t const n(sqlite3_column_bytes(s, i));
+
+  if (!p)
+  {
+    return T();
+  }
+
+  auto const misaligned(reinterpret_cast<std::uintptr_t>(p) % alignof(E));
+
+  assert(!(n % sizeof(E)) && "blob size is not a multiple of the element");
+  assert(!misaligned && "misaligned blob, use get_span()");
+
+  return (n % sizeof(E)) || misaligned ?
+    T() :
+    T(static_cast<E*>(p), n / sizeof(E));
+}
+#endif // __cpp_lib_span
+
+class row_view;
+
+template <typename T>
+inline std::enable_if_t<
+  std::is_same_v<T, row_view>,
+  T
+>
+get(sqlite3_stmt* const s, int const i = 0) noexcept
+{
+  return T(s, i);
+}
+
 namespace detail
 {
 
@@ -786,7 +1200,70 @@ inline auto get(S const& s, int const i = 0) noexcept(
   return get<A...>(s.get(), i);
 }
 
+//row_view////////////////////////////////////////////////////////////////////
+// the columns of the current row from column i on, decoded only when
+// accessed, text and blobs are not copied, valid until the statement is
+// stepped or reset, as a foreach_row() argument it must come last
+class row_view
+{
+  sqlite3_stmt* s_;
+  int i_;
+
+public:
+  explicit row_view(sqlite3_stmt* const s, int const i = 0) noexcept :
+    s_(s),
+    i_(i)
+  {
+  }
+
+  auto stmt() const noexcept { return s_; }
+
+  int size() const noexcept { return sqlite3_column_count(s_) - i_; }
+
+  // index of the column named n, or -1
+  int index(std::string_view const& n) const noexcept
+  {
+    for (int j{}, e(size()); j != e; ++j)
+    {
+      if (auto const c(sqlite3_column_name(s_, i_ + j)); c && (n == c))
+      {
+        return j;
+      }
+    }
+
+    return -1;
+  }
+
+  int type(int const j) const noexcept
+  {
+    return sqlite3_column_type(s_, i_ + j);
+  }
+
+  bool is_null(int const j) const noexcept
+  {
+    return SQLITE_NULL == type(j);
+  }
+
+  template <typename T>
+  auto get(int const j) const noexcept(noexcept(squ::get<T>(s_, i_ + j)))
+  {
+    return squ::get<T>(s_, i_ + j);
+  }
+
+  template <typename T>
+  auto get(std::string_view const& n) const noexcept(
+    noexcept(squ::get<T>(s_, i_)))
+  {
+    auto const j(index(n));
+    assert(-1 != j);
+
+    return get<T>(j);
+  }
+};
+
 //execget/////////////////////////////////////////////////////////////////////
+// an empty optional means no row, or that the statement was busy, locked or
+// interrupted, which sqlite3_errcode() then reports
 template <typename T, int I = 1, typename S, typename ...A>
 inline auto execget(S&& s, int const i = 0, A&& ...args) noexcept(
   noexcept(exec<I>(std::forward<S>(s), std::forward<A>(args)...),
@@ -795,7 +1272,8 @@ inline auto execget(S&& s, int const i = 0, A&& ...args) noexcept(
 )
 {
   auto const r(exec<I>(std::forward<S>(s), std::forward<A>(args)...));
-  assert((SQLITE_DONE == r) || (SQLITE_ROW == r));
+  assert((SQLITE_DONE == r) || (SQLITE_ROW == r) || (SQLITE_BUSY == r) ||
+    (SQLITE_LOCKED == r) || (SQLITE_INTERRUPT == r));
 
   return SQLITE_ROW == r ?
     std::optional<T>(get<T>(s, i)) :
@@ -810,7 +1288,8 @@ inline auto rexecget(S&& s, int const i = 0, A&& ...args) noexcept(
 )
 {
   auto const r(rexec<I>(std::forward<S>(s), std::forward<A>(args)...));
-  assert((SQLITE_DONE == r) || (SQLITE_ROW == r));
+  assert((SQLITE_DONE == r) || (SQLITE_ROW == r) || (SQLITE_BUSY == r) ||
+    (SQLITE_LOCKED == r) || (SQLITE_INTERRUPT == r));
 
   return SQLITE_ROW == r ?
     std::optional<T>(get<T>(s, i)) :
@@ -1232,6 +1711,11 @@ inline auto foreach_row(S&& s, F const f, int const i,
       case SQLITE_DONE:;
         break;
 
+      case SQLITE_BUSY:
+      case SQLITE_LOCKED:
+      case SQLITE_INTERRUPT:
+        break;
+
       default:
         assert(!"unhandled result from exec");
     }
@@ -1270,6 +1754,11 @@ inline auto foreach_row(S&& s, F const f, int const i,
       case SQLITE_DONE:;
         break;
 
+      case SQLITE_BUSY:
+      case SQLITE_LOCKED:
+      case SQLITE_INTERRUPT:
+        break;
+
       default:
         assert(!"unhandled result from exec");
     }
@@ -1301,6 +1790,11 @@ inline auto foreach_row(S&& s, F const f, int const i,
       case SQLITE_DONE:;
         break;
 
+      case SQLITE_BUSY:
+      case SQLITE_LOCKED:
+      case SQLITE_INTERRUPT:
+        break;
+
       default:
         assert(!"unhandled result from exec");
     }
@@ -1399,6 +1893,11 @@ inline auto container_push(S&& s, C& c, int const i)
       case SQLITE_DONE:
         break;
 
+      case SQLITE_BUSY:
+      case SQLITE_LOCKED:
+      case SQLITE_INTERRUPT:
+        break;
+
       default:
         assert(!"unhandled result from exec");
     }
@@ -1426,6 +1925,11 @@ inline auto container_push(S&& s, C& c, T n, int const i)
       case SQLITE_DONE:
         break;
 
+      case SQLITE_BUSY:
+      case SQLITE_LOCKED:
+      case SQLITE_INTERRUPT:
+        break;
+
       default:
         assert(!"unhandled result from exec");
     }
@@ -1553,6 +2057,7981 @@ inline auto reset_all_busy(D&& db) noexcept(
   return reset_all_busy(db.get());
 }
 
-}
+
+//checkpointer////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_THREADS)
+struct checkpoint_config
+{
+  // wal sizes, in frames, at which a checkpoint is run in the background and
+  // at which it is escalated to SQLITE_CHECKPOINT_RESTART and _TRUNCATE
+  int passive{1000};
+  int restart{8000};
+  int truncate{32000};
+
+  // how long RESTART and TRUNCATE checkpoints wait for readers, in ms
+  int busy_timeout{100};
+};
+
+struct checkpoint_stats
+{
+  int mode;
+  int result;
+
+  int wal_frames;
+  int frames_checkpointed;
+  sqlite3_int64 wal_bytes;
+
+  std::chrono::nanoseconds duration;
+
+  std::uint64_t count;
+};
+
+class checkpointer
+{
+  unique_db_t db_;
+
+  checkpoint_config const cfg_;
+
+  sqlite3_int64 frame_bytes_{};
+
+  std::atomic<int> frames_{};
+
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+
+  bool pending_{};
+  bool quit_{};
+
+  checkpoint_stats stats_{};
+
+  std::thread thread_;
+
+  static int wal_hook(void* const p, sqlite3*, char const*,
+    int const n) noexcept
+  {
+    auto& c(*static_cast<checkpointer*>(p));
+
+    c.frames_.store(n, std::memory_order_relaxed);
+
+    if (n >= c.cfg_.passive)
+    {
+      c.request();
+    }
+
+    return SQLITE_OK;
+  }
+
+  void run(int const n) noexcept
+  {
+    auto const mode(
+      n >= cfg_.truncate ? SQLITE_CHECKPOINT_TRUNCATE :
+      n >= cfg_.restart ? SQLITE_CHECKPOINT_RESTART :
+      SQLITE_CHECKPOINT_PASSIVE
+    );
+
+    int log(-1), ckpt(-1);
+
+    auto const start(std::chrono::steady_clock::now());
+
+    auto const r(
+      sqlite3_wal_checkpoint_v2(db_.get(), nullptr, mode, &log, &ckpt)
+    );
+
+    auto const duration(std::chrono::steady_clock::now() - start);
+
+    std::lock_guard<std::mutex> l(m_);
+
+    stats_.mode = mode;
+    stats_.result = r;
+    stats_.wal_frames = log;
+    stats_.frames_checkpointed = ckpt;
+    stats_.wal_bytes = log > 0 ? 32 + log * frame_bytes_ : 0;
+    stats_.duration = duration;
+    ++stats_.count;
+  }
+
+  void loop() noexcept
+  {
+    std::unique_lock<std::mutex> l(m_);
+
+    for (;;)
+    {
+      cv_.wait(l, [&]() noexcept { return pending_ || quit_; });
+
+      if (quit_)
+      {
+        break;
+      }
+      else
+      {
+        pending_ = false;
+
+        l.unlock();
+        run(frames_.load(std::memory_order_relaxed));
+        l.lock();
+      }
+    }
+  }
+
+public:
+  explicit checkpointer(char const* const filename,
+    checkpoint_config const& cfg = {}, char const* const zvfs = nullptr) :
+    db_(open_unique(filename, SQLITE_OPEN_READWRITE, zvfs)),
+    cfg_(cfg)
+  {
+    assert(db_);
+
+    if (db_)
+    {
+      sqlite3_busy_timeout(db_.get(), cfg_.busy_timeout);
+
+      // the pager enters wal mode only after its first read, checkpoints
+      // are no-ops until then
+      execget<int>(db_, "PRAGMA schema_version");
+
+      // every wal frame is a 24 byte header followed by a page
+      frame_bytes_ = 24 + sqlite3_int64(
+        execget<int>(db_, "PRAGMA page_size").value_or(4096)
+      );
+
+      thread_ = std::thread(&checkpointer::loop, this);
+    }
+  }
+
+  checkpointer(checkpointer const&) = delete;
+
+  ~checkpointer()
+  {
+    {
+      std::lock_guard<std::mutex> l(m_);
+      quit_ = true;
+    }
+
+    cv_.notify_one();
+
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+
+  checkpointer& operator=(checkpointer const&) = delete;
+
+  explicit operator bool() const noexcept
+  {
+    return bool(db_);
+  }
+
+  // takes over checkpointing for the writing connection db, disabling its
+  // autocheckpoint, the connection must be detached before *this is destroyed
+  void attach(sqlite3* const db) noexcept
+  {
+    sqlite3_wal_hook(db, &checkpointer::wal_hook, this);
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  void attach(D const& db) noexcept
+  {
+    attach(db.get());
+  }
+
+  static void detach(sqlite3* const db) noexcept
+  {
+    sqlite3_wal_hook(db, nullptr, nullptr);
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  static void detach(D const& db) noexcept
+  {
+    detach(db.get());
+  }
+
+  // schedule a checkpoint, regardless of the wal size
+  void request() noexcept
+  {
+    {
+      std::lock_guard<std::mutex> l(m_);
+      pending_ = true;
+    }
+
+    cv_.notify_one();
+  }
+
+  auto stats() const noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    return stats_;
+  }
+
+  // wal size reported by the last commit
+  auto wal_frames() const noexcept
+  {
+    return frames_.load(std::memory_order_relaxed);
+  }
+};
+#endif // SQU_ENABLE_THREADS
+
+
+//busy_handler////////////////////////////////////////////////////////////////
+struct busy_config
+{
+  // first and largest sleep between retries, sleeps double on every retry
+  // and are jittered down by up to one half
+  std::chrono::microseconds initial{100};
+  std::chrono::microseconds max{50000};
+
+  // give up and let SQLITE_BUSY through after this long
+  std::chrono::microseconds deadline{5000000};
+};
+
+class busy_handler
+{
+public:
+  // bucket i counts waits of [2^(i - 1), 2^i) us, bucket 0 waits under 1 us
+  using histogram_t = std::array<std::uint64_t, 32>;
+
+private:
+  sqlite3* const db_;
+
+  busy_config const cfg_;
+
+  std::chrono::steady_clock::time_point start_;
+  int bucket_{-1};
+
+  std::uint64_t seed_;
+
+  std::array<std::atomic<std::uint64_t>, std::tuple_size_v<histogram_t>> h_{};
+
+  std::atomic<std::uint64_t> waits_{};
+  std::atomic<std::uint64_t> timeouts_{};
+
+  static int bucket(std::chrono::microseconds const w) noexcept
+  {
+    int b{};
+
+    for (auto c(std::uint64_t(w.count())); c; c >>= 1)
+    {
+      ++b;
+    }
+
+    return std::min(b, int(std::tuple_size_v<histogram_t>) - 1);
+  }
+
+  auto jitter(std::chrono::microseconds const d) noexcept
+  {
+    // xorshift64
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 7;
+    seed_ ^= seed_ << 17;
+
+    auto const h(d.count() / 2);
+
+    return std::chrono::microseconds(d.count() - (h ? seed_ % (h + 1) : 0));
+  }
+
+  static int handler(void* const p, int const n) noexcept
+  {
+    auto& b(*static_cast<busy_handler*>(p));
+
+    auto const now(std::chrono::steady_clock::now());
+
+    if (!n)
+    {
+      b.start_ = now;
+      b.bucket_ = -1;
+
+      b.waits_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto const waited(
+      std::chrono::duration_cast<std::chrono::microseconds>(now - b.start_)
+    );
+
+    // a wait is accounted for in the bucket of its latest length
+    if (auto const k(bucket(waited)); k != b.bucket_)
+    {
+      if (-1 != b.bucket_)
+      {
+        b.h_[b.bucket_].fetch_sub(1, std::memory_order_relaxed);
+      }
+
+      b.h_[b.bucket_ = k].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (waited >= b.cfg_.deadline)
+    {
+      b.timeouts_.fetch_add(1, std::memory_order_relaxed);
+
+      return 0;
+    }
+    else
+    {
+      auto const d(
+        n < 31 ?
+        std::min(b.cfg_.initial * (1 << n), b.cfg_.max) :
+        b.cfg_.max
+      );
+
+      // sleep as sqlite does, through the default vfs
+      auto const v(sqlite3_vfs_find(nullptr));
+
+      v->xSleep(v, int(std::min(b.jitter(d), b.cfg_.deadline - waited)
+        .count()));
+
+      return 1;
+    }
+  }
+
+public:
+  explicit busy_handler(sqlite3* const db, busy_config const& cfg = {})
+    noexcept :
+    db_(db),
+    cfg_(cfg),
+    seed_(std::uint64_t(reinterpret_cast<std::uintptr_t>(this)) | 1)
+  {
+    sqlite3_busy_handler(db_, &busy_handler::handler, this);
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  explicit busy_handler(D const& db, busy_config const& cfg = {}) noexcept :
+    busy_handler(db.get(), cfg)
+  {
+  }
+
+  busy_handler(busy_handler const&) = delete;
+
+  ~busy_handler()
+  {
+    sqlite3_busy_handler(db_, nullptr, nullptr);
+  }
+
+  busy_handler& operator=(busy_handler const&) = delete;
+
+  auto histogram() const noexcept
+  {
+    histogram_t r;
+
+    for (std::size_t i{}; i != r.size(); ++i)
+    {
+      r[i] = h_[i].load(std::memory_order_relaxed);
+    }
+
+    return r;
+  }
+
+  // number of lock waits and of those that ran past the deadline
+  auto waits() const noexcept
+  {
+    return waits_.load(std::memory_order_relaxed);
+  }
+
+  auto timeouts() const noexcept
+  {
+    return timeouts_.load(std::memory_order_relaxed);
+  }
+};
+
+#if defined(SQLITE_ENABLE_UNLOCK_NOTIFY)
+//blocking_step///////////////////////////////////////////////////////////////
+namespace detail
+{
+
+struct unlock_notification
+{
+  bool fired{};
+
+  std::mutex m;
+  std::condition_variable cv;
+
+  static void notify(void** const a, int const n) noexcept
+  {
+    for (int i{}; i != n; ++i)
+    {
+      auto& un(*static_cast<unlock_notification*>(a[i]));
+
+      {
+        std::lock_guard<std::mutex> l(un.m);
+        un.fired = true;
+      }
+
+      un.cv.notify_one();
+    }
+  }
+};
+
+inline auto wait_for_unlock_notify(sqlite3* const db) noexcept
+{
+  unlock_notification un;
+
+  // SQLITE_LOCKED here means waiting would deadlock
+  auto const r(sqlite3_unlock_notify(db, &unlock_notification::notify, &un));
+  assert((SQLITE_OK == r) || (SQLITE_LOCKED == r));
+
+  if (SQLITE_OK == r)
+  {
+    std::unique_lock<std::mutex> l(un.m);
+    un.cv.wait(l, [&]() noexcept { return un.fired; });
+  }
+
+  return r;
+}
+
+}
+
+// step a statement on a shared-cache connection, sleeping until the blocking
+// connection concludes its transaction instead of failing with SQLITE_LOCKED
+inline auto blocking_step(sqlite3_stmt* const s) noexcept
+{
+  auto const db(sqlite3_db_handle(s));
+
+  for (;;)
+  {
+    if (auto const r(sqlite3_step(s));
+      (SQLITE_LOCKED != (r & 0xff)) ||
+      (SQLITE_LOCKED_SHAREDCACHE != sqlite3_extended_errcode(db)))
+    {
+      return r;
+    }
+    else if (auto const r(detail::wait_for_unlock_notify(db));
+      SQLITE_OK != r)
+    {
+      return r;
+    }
+    else
+    {
+      sqlite3_reset(s);
+    }
+  }
+}
+
+template <typename S, typename = std::enable_if_t<is_stmt_v<S>>>
+inline auto blocking_step(S const& s) noexcept(
+  noexcept(blocking_step(s.get()))
+)
+{
+  return blocking_step(s.get());
+}
+#endif // SQLITE_ENABLE_UNLOCK_NOTIFY
+
+
+//export//////////////////////////////////////////////////////////////////////
+struct export_options
+{
+  // size of the output buffer, the sink sees writes of about this size
+  std::size_t buffer{std::size_t(1) << 20};
+
+  // csv only
+  char separator{','};
+  bool header{true};
+};
+
+namespace detail
+{
+
+inline auto make_sink(std::FILE* const f) noexcept
+{
+  return [f](char const* const p, std::size_t const n) noexcept
+    {
+      return n == std::fwrite(p, 1, n, f);
+    };
+}
+
+#if __has_include(<unistd.h>)
+inline auto make_sink(int const fd) noexcept
+{
+  return [fd](char const* p, std::size_t n) noexcept
+    {
+      while (n)
+      {
+        if (auto const w(::write(fd, p, n)); w >= 0)
+        {
+          p += w;
+          n -= std::size_t(w);
+        }
+        else if (EINTR != errno)
+        {
+          return false;
+        }
+      }
+
+      return true;
+    };
+}
+#endif
+
+template <typename K>
+inline std::enable_if_t<
+  std::is_invocable_r_v<bool, K&, char const*, std::size_t>,
+  K&
+>
+make_sink(K& k) noexcept
+{
+  return k;
+}
+
+template <typename K>
+class export_buffer
+{
+  K& sink_;
+
+  std::size_t const cap_;
+  std::unique_ptr<char[]> const b_;
+
+  char* p_;
+  bool ok_{true};
+
+public:
+  // minimum room reserve() guarantees without a size argument, enough for
+  // any formatted number
+  static constexpr std::size_t slack{64};
+
+  export_buffer(K& sink, std::size_t const cap) :
+    sink_(sink),
+    cap_(std::max(cap, 4 * slack)),
+    b_(new char[cap_]),
+    p_(b_.get())
+  {
+  }
+
+  export_buffer(export_buffer const&) = delete;
+
+  export_buffer& operator=(export_buffer const&) = delete;
+
+  auto ok() const noexcept
+  {
+    return ok_;
+  }
+
+  bool flush() noexcept(noexcept(sink_(nullptr, 0)))
+  {
+    if (auto const n(std::size_t(p_ - b_.get())); n && ok_)
+    {
+      ok_ = sink_(b_.get(), n);
+    }
+
+    p_ = b_.get();
+
+    return ok_;
+  }
+
+  // returns a pointer to at least n free bytes, n must be < the capacity
+  char* reserve(std::size_t const n = slack) noexcept(noexcept(flush()))
+  {
+    assert(n < cap_);
+    if (std::size_t(b_.get() + cap_ - p_) < n)
+    {
+      flush();
+    }
+
+    return p_;
+  }
+
+  void commit(char* const p) noexcept
+  {
+    assert((p >= p_) && (p <= b_.get() + cap_));
+    p_ = p;
+  }
+
+  void put(char const c) noexcept(noexcept(reserve()))
+  {
+    *reserve(1) = c;
+    ++p_;
+  }
+
+  void write(char const* p, std::size_t n) noexcept(noexcept(reserve()))
+  {
+    // large writes go out in buffer-sized pieces
+    while (n)
+    {
+      auto const m(std::min(n, cap_ / 2));
+
+      std::memcpy(reserve(m), p, m);
+      p_ += m;
+
+      p += m;
+      n -= m;
+    }
+  }
+
+  template <typename T>
+  void number(T const v) noexcept(noexcept(reserve()))
+  {
+    auto const p(reserve());
+
+    commit(std::to_chars(p, p + slack, v).ptr);
+  }
+
+  void hex(unsigned char const* p, std::size_t n) noexcept(noexcept(reserve()))
+  {
+    constexpr char const digits[]{"0123456789abcdef"};
+
+    while (n)
+    {
+      auto const m(std::min(n, cap_ / 4));
+
+      auto q(reserve(2 * m));
+
+      for (auto const e(p + m); p != e; ++p)
+      {
+        *q++ = digits[*p >> 4];
+        *q++ = digits[*p & 0xf];
+      }
+
+      p_ = q;
+      n -= m;
+    }
+  }
+};
+
+template <typename B>
+inline void csv_field(B& b, char const* p, std::size_t const n,
+  char const sep) noexcept(noexcept(b.put({})))
+{
+  auto const e(p + n);
+
+  if (std::find_if(p, e, [sep](char const c) noexcept
+      {
+        return (sep == c) || ('"' == c) || ('\n' == c) || ('\r' == c);
+      }
+    ) == e
+  )
+  {
+    b.write(p, n);
+  }
+  else
+  {
+    b.put('"');
+
+    // quotes are escaped by doubling them
+    for (char const* q; (q = static_cast<char const*>(
+      std::memchr(p, '"', std::size_t(e - p)))); p = q + 1)
+    {
+      b.write(p, std::size_t(q - p) + 1);
+      b.put('"');
+    }
+
+    b.write(p, std::size_t(e - p));
+    b.put('"');
+  }
+}
+
+template <typename B>
+inline void json_string(B& b, char const* p, std::size_t const n)
+  noexcept(noexcept(b.put({})))
+{
+  constexpr char const digits[]{"0123456789abcdef"};
+
+  b.put('"');
+
+  auto const e(p + n);
+
+  for (auto q(p);; ++q)
+  {
+    while ((q != e) && (static_cast<unsigned char>(*q) >= 0x20) &&
+      ('"' != *q) && ('\\' != *q))
+    {
+      ++q;
+    }
+
+    b.write(p, std::size_t(q - p));
+
+    if (q == e)
+    {
+      break;
+    }
+    else
+    {
+      auto const c(static_cast<unsigned char>(*q));
+
+      switch (c)
+      {
+        case '"':
+        case '\\':
+          b.put('\\');
+          b.put(char(c));
+          break;
+
+        case '\n':
+          b.write("\\n", 2);
+          break;
+
+        case '\r':
+          b.write("\\r", 2);
+          break;
+
+        case '\t':
+          b.write("\\t", 2);
+          break;
+
+        default:
+          b.write("\\u00", 4);
+          b.put(digits[c >> 4]);
+          b.put(digits[c & 0xf]);
+      }
+
+      p = q + 1;
+    }
+  }
+
+  b.put('"');
+}
+
+template <typename F>
+inline auto export_rows(sqlite3_stmt* const s, F const f) noexcept(
+  noexcept(f())
+)
+{
+  decltype(exec(s)) r;
+
+  for (;;)
+  {
+    switch (r = exec(s))
+    {
+      case SQLITE_ROW:
+        if (f())
+        {
+          continue;
+        }
+        else
+        {
+          return SQLITE_IOERR;
+        }
+
+      case SQLITE_DONE:
+        break;
+
+      case SQLITE_BUSY:
+      case SQLITE_LOCKED:
+      case SQLITE_INTERRUPT:
+        break;
+
+      default:
+        assert(!"unhandled result from exec");
+    }
+
+    break;
+  }
+
+  return r;
+}
+
+}
+
+// write the rows of s as RFC 4180 csv to a FILE*, a file descriptor or a
+// bool(char const*, std::size_t) sink, returns SQLITE_DONE on success and
+// SQLITE_IOERR if the sink failed
+template <typename K>
+inline auto export_csv(sqlite3_stmt* const s, K&& k,
+  export_options const& o = {})
+{
+  auto&& sink(detail::make_sink(k));
+
+  detail::export_buffer<std::remove_reference_t<decltype(sink)>> b(sink,
+    o.buffer);
+
+  auto const n(sqlite3_column_count(s));
+
+  if (o.header)
+  {
+    for (int i{}; i != n; ++i)
+    {
+      if (i)
+      {
+        b.put(o.separator);
+      }
+
+      auto const name(sqlite3_column_name(s, i));
+
+      detail::csv_field(b, name, std::strlen(name), o.separator);
+    }
+
+    b.put('\n');
+  }
+
+  auto const r(
+    detail::export_rows(s, [&]()
+      {
+        for (int i{}; i != n; ++i)
+        {
+          if (i)
+          {
+            b.put(o.separator);
+          }
+
+          switch (sqlite3_column_type(s, i))
+          {
+            case SQLITE_INTEGER:
+              b.number(sqlite3_column_int64(s, i));
+              break;
+
+            case SQLITE_FLOAT:
+              b.number(sqlite3_column_double(s, i));
+              break;
+
+            case SQLITE_TEXT:
+            {
+              auto const p(get<char const*>(s, i));
+
+              detail::csv_field(b, p, std::size_t(sqlite3_column_bytes(s, i)),
+                o.separator);
+
+              break;
+            }
+
+            case SQLITE_BLOB:
+            {
+              auto const p(static_cast<unsigned char const*>(
+                sqlite3_column_blob(s, i)));
+
+              b.hex(p, std::size_t(sqlite3_column_bytes(s, i)));
+
+              break;
+            }
+
+            default:
+              break;
+          }
+        }
+
+        b.put('\n');
+
+        return b.ok();
+      }
+    )
+  );
+
+  return b.flush() ? r : SQLITE_IOERR;
+}
+
+// write the rows of s as newline delimited json objects keyed by column name,
+// blobs are written as hex strings and non-finite reals as null
+template <typename K>
+inline auto export_ndjson(sqlite3_stmt* const s, K&& k,
+  export_options const& o = {})
+{
+  auto&& sink(detail::make_sink(k));
+
+  detail::export_buffer<std::remove_reference_t<decltype(sink)>> b(sink,
+    o.buffer);
+
+  auto const n(sqlite3_column_count(s));
+
+  // keys are escaped once, up front
+  std::vector<std::string> keys;
+  keys.reserve(n);
+
+  {
+    std::string key;
+
+    auto ks([&](char const* const p, std::size_t const m) noexcept
+      {
+        key.append(p, m);
+
+        return true;
+      }
+    );
+
+    detail::export_buffer<decltype(ks)> kb(ks, 256);
+
+    for (int i{}; i != n; ++i)
+    {
+      kb.put(i ? ',' : '{');
+
+      auto const name(sqlite3_column_name(s, i));
+      detail::json_string(kb, name, std::strlen(name));
+
+      kb.put(':');
+      kb.flush();
+
+      keys.emplace_back(std::move(key));
+      key.clear();
+    }
+  }
+
+  auto const r(
+    detail::export_rows(s, [&]()
+      {
+        for (int i{}; i != n; ++i)
+        {
+          b.write(keys[i].data(), keys[i].size());
+
+          switch (sqlite3_column_type(s, i))
+          {
+            case SQLITE_INTEGER:
+              b.number(sqlite3_column_int64(s, i));
+              break;
+
+            case SQLITE_FLOAT:
+              if (auto const v(sqlite3_column_double(s, i)); std::isfinite(v))
+              {
+                b.number(v);
+              }
+              else
+              {
+                b.write("null", 4);
+              }
+
+              break;
+
+            case SQLITE_TEXT:
+            {
+              auto const p(get<char const*>(s, i));
+
+              detail::json_string(b, p,
+                std::size_t(sqlite3_column_bytes(s, i)));
+
+              break;
+            }
+
+            case SQLITE_BLOB:
+            {
+              auto const p(static_cast<unsigned char const*>(
+                sqlite3_column_blob(s, i)));
+
+              b.put('"');
+              b.hex(p, std::size_t(sqlite3_column_bytes(s, i)));
+              b.put('"');
+
+              break;
+            }
+
+            default:
+              b.write("null", 4);
+          }
+        }
+
+        b.write(n ? "}\n" : "{}\n", n ? 2 : 3);
+
+        return b.ok();
+      }
+    )
+  );
+
+  return b.flush() ? r : SQLITE_IOERR;
+}
+
+template <typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto export_csv(S const& s, A&& ...args)
+{
+  return export_csv(s.get(), std::forward<A>(args)...);
+}
+
+template <typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto export_ndjson(S const& s, A&& ...args)
+{
+  return export_ndjson(s.get(), std::forward<A>(args)...);
+}
+
+
+//bounded_queue///////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_THREADS)
+namespace detail
+{
+
+// hands elements between threads, push() waits while the queue is full and
+// pop() while it is empty, both fail once the queue is closed
+template <typename T>
+class bounded_queue
+{
+  std::vector<T> v_;
+
+  std::size_t head_{};
+  std::size_t size_{};
+
+  bool closed_{};
+
+  std::mutex m_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+
+public:
+  explicit bounded_queue(std::size_t const n) : v_(std::max(n, std::size_t(1)))
+  {
+  }
+
+  bounded_queue(bounded_queue const&) = delete;
+
+  bounded_queue& operator=(bounded_queue const&) = delete;
+
+  // both return false once the queue is closed, pop() only after it has
+  // also been drained
+  bool push(T&& t)
+  {
+    {
+      std::unique_lock<std::mutex> l(m_);
+
+      not_full_.wait(l, [&]() noexcept
+        {
+          return closed_ || (size_ != v_.size());
+        }
+      );
+
+      if (closed_)
+      {
+        return false;
+      }
+      else
+      {
+        v_[(head_ + size_++) % v_.size()] = std::move(t);
+      }
+    }
+
+    not_empty_.notify_one();
+
+    return true;
+  }
+
+  bool pop(T& t)
+  {
+    {
+      std::unique_lock<std::mutex> l(m_);
+
+      not_empty_.wait(l, [&]() noexcept { return closed_ || size_; });
+
+      if (!size_)
+      {
+        return false;
+      }
+      else
+      {
+        t = std::move(v_[head_]);
+
+        head_ = (head_ + 1) % v_.size();
+        --size_;
+      }
+    }
+
+    not_full_.notify_one();
+
+    return true;
+  }
+
+  void close() noexcept
+  {
+    {
+      std::lock_guard<std::mutex> l(m_);
+      closed_ = true;
+    }
+
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+};
+
+}
+#endif // SQU_ENABLE_THREADS
+
+
+//import_csv//////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_IMPORT_CSV)
+enum column_type
+{
+  AS_TEXT,
+  AS_INTEGER,
+  AS_REAL,
+  AS_BLOB,
+  AS_NUMERIC // integer, else real, else text
+};
+
+struct import_options
+{
+  char separator{','};
+
+  // take column names from the first record
+  bool header{true};
+
+  // bind empty fields as NULL
+  bool empty_is_null{};
+
+  // conversion per column, columns past the end are imported AS_TEXT
+  std::vector<column_type> types;
+
+  // rows per transaction, rows per parsed batch and batches in flight
+  std::size_t commit_rows{std::size_t(1) << 18};
+  std::size_t batch_rows{std::size_t(1) << 12};
+  std::size_t depth{4};
+
+  std::size_t read_size{std::size_t(1) << 20};
+};
+
+struct import_result
+{
+  int result;
+  std::uint64_t rows;
+};
+
+namespace detail
+{
+
+struct csv_batch
+{
+  // unquoted field bytes, fields of record i are
+  // [records[i], records[i + 1]) in fields, each a [begin, end) into data
+  std::string data;
+
+  std::vector<std::pair<std::size_t, std::size_t>> fields;
+  std::vector<std::size_t> records{0};
+
+  auto size() const noexcept
+  {
+    return records.size() - 1;
+  }
+
+  void clear() noexcept
+  {
+    data.clear();
+    fields.clear();
+    records.resize(1);
+  }
+};
+
+class csv_parser
+{
+  char const sep_;
+
+  std::size_t begin_{};
+
+  bool quoted_{};
+  bool quote_{};
+  bool field_{};
+
+public:
+  explicit csv_parser(char const sep) noexcept : sep_(sep)
+  {
+  }
+
+  void end_field(csv_batch& b)
+  {
+    b.fields.emplace_back(begin_, b.data.size());
+    begin_ = b.data.size();
+
+    field_ = quoted_ = quote_ = false;
+  }
+
+  // blank lines are skipped
+  void end_record(csv_batch& b)
+  {
+    if (field_ || (b.fields.size() != b.records.back()))
+    {
+      end_field(b);
+
+      b.records.push_back(b.fields.size());
+    }
+  }
+
+  // parsing continues into an empty batch
+  void next(csv_batch const& b) noexcept
+  {
+    assert(b.data.empty());
+    begin_ = b.data.size();
+  }
+
+  // parse [p, e), returns the number of bytes consumed, which is less than
+  // e - p only when the batch filled up with n records, records never
+  // straddle batches
+  std::size_t parse(csv_batch& b, char const* const p, char const* const e,
+    std::size_t const n)
+  {
+    auto q(p);
+
+    while ((q != e) && (b.size() < n))
+    {
+      if (quoted_)
+      {
+        if (quote_)
+        {
+          quote_ = false;
+
+          if ('"' == *q)
+          {
+            // an escaped quote
+            b.data.push_back(*q++);
+
+            continue;
+          }
+          else
+          {
+            quoted_ = false;
+          }
+        }
+        else
+        {
+          auto const f(static_cast<char const*>(
+            std::memchr(q, '"', std::size_t(e - q))));
+
+          b.data.append(q, f ? f : e);
+
+          if (f)
+          {
+            quote_ = true;
+            q = f + 1;
+          }
+          else
+          {
+            q = e;
+          }
+
+          continue;
+        }
+      }
+
+      // unquoted run
+      auto f(q);
+
+      while ((f != e) && (sep_ != *f) && ('\n' != *f) && ('"' != *f))
+      {
+        ++f;
+      }
+
+      if (f != q)
+      {
+        b.data.append(q, f);
+        field_ = true;
+      }
+
+      if ((q = f) != e)
+      {
+        switch (auto const c(*q++); c)
+        {
+          case '"':
+            if (field_)
+            {
+              // a stray quote inside an unquoted field is kept
+              b.data.push_back(c);
+            }
+            else
+            {
+              quoted_ = field_ = true;
+            }
+
+            break;
+
+          case '\n':
+            if ((b.data.size() > begin_) && ('\r' == b.data.back()))
+            {
+              b.data.pop_back();
+            }
+
+            end_record(b);
+
+            break;
+
+          default:
+            end_field(b);
+        }
+      }
+    }
+
+    return std::size_t(q - p);
+  }
+};
+
+inline std::string quote_identifier(std::string_view const sv)
+{
+  std::string r(1, '"');
+
+  for (auto const c: sv)
+  {
+    r.append('"' == c ? 2 : 1, c);
+  }
+
+  return r += '"';
+}
+
+inline int bind_field(sqlite3_stmt* const s, int const i,
+  column_type const t, bool const empty_is_null, char const* const p,
+  std::size_t const n) noexcept
+{
+  if (!n && empty_is_null)
+  {
+    return sqlite3_bind_null(s, i);
+  }
+  else
+  {
+    auto const e(p + n);
+
+    switch (t)
+    {
+      case AS_INTEGER:
+      case AS_NUMERIC:
+        if (sqlite3_int64 v{};
+          n && (std::from_chars(p, e, v).ptr == e))
+        {
+          return sqlite3_bind_int64(s, i, v);
+        }
+        else if (AS_INTEGER == t)
+        {
+          break;
+        }
+
+        [[fallthrough]];
+
+      case AS_REAL:
+        if (double v{}; n && (std::from_chars(p, e, v).ptr == e))
+        {
+          return sqlite3_bind_double(s, i, v);
+        }
+
+        break;
+
+      case AS_BLOB:
+        return sqlite3_bind_blob64(s, i, p, n, SQLITE_STATIC);
+
+      default:
+        break;
+    }
+
+    // the batch outlives the step, so text needs no copy
+    return sqlite3_bind_text64(s, i, p, n, SQLITE_STATIC, SQLITE_UTF8);
+  }
+}
+
+}
+
+// bulk load the csv file at path into table, the file is read and parsed on
+// a separate thread while the calling thread inserts the rows
+inline import_result import_csv(sqlite3* const db,
+  std::string_view const& table, char const* const path,
+  import_options const& o = {})
+{
+  std::unique_ptr<std::FILE, int (*)(std::FILE*)> const f(
+    std::fopen(path, "rb"), &std::fclose);
+
+  if (!f)
+  {
+    return {SQLITE_CANTOPEN, 0};
+  }
+
+  using batch_t = std::unique_ptr<detail::csv_batch>;
+
+  auto const rows(std::max(o.batch_rows, std::size_t(1)));
+
+  detail::bounded_queue<batch_t> full(o.depth), empty(o.depth + 1);
+
+  for (auto i(o.depth + 1); i; --i)
+  {
+    empty.push(std::make_unique<detail::csv_batch>());
+  }
+
+  std::thread parser([&]()
+    {
+      detail::csv_parser p(o.separator);
+
+      std::unique_ptr<char[]> const buf(new char[o.read_size]);
+
+      batch_t b;
+
+      if (empty.pop(b))
+      {
+        for (std::size_t n; (n = std::fread(buf.get(), 1, o.read_size,
+          f.get()));)
+        {
+          for (auto q(buf.get()), e(q + n); q != e;)
+          {
+            // hand the batch over before waiting for an empty one, with
+            // depth 0 there is no other
+            if (q += p.parse(*b, q, e, rows); b->size() == rows)
+            {
+              if (!full.push(std::move(b)) || !empty.pop(b))
+              {
+                return;
+              }
+
+              b->clear();
+              p.next(*b);
+            }
+          }
+        }
+
+        // a last record need not end with a newline
+        p.end_record(*b);
+
+        full.push(std::move(b));
+      }
+
+      full.close();
+    }
+  );
+
+  int r(SQLITE_DONE);
+  std::uint64_t imported{};
+
+  unique_stmt_t s;
+  int n{};
+
+  auto const autocommit(sqlite3_get_autocommit(db));
+
+  std::size_t pending{};
+
+  for (batch_t b; full.pop(b);)
+  {
+    std::size_t j{};
+
+    if (!s)
+    {
+      if (!b->size())
+      {
+        empty.push(std::move(b));
+
+        continue;
+      }
+
+      // the first record decides the column count
+      n = int(b->records[1] - b->records[0]);
+
+      std::string sql("INSERT INTO ");
+      sql.append(detail::quote_identifier(table));
+
+      if (o.header)
+      {
+        for (int i{}; i != n; ++i)
+        {
+          auto const& fl(b->fields[i]);
+
+          sql.append(i ? "," : "(").append(detail::quote_identifier(
+            {b->data.data() + fl.first, fl.second - fl.first}));
+        }
+
+        sql.push_back(')');
+
+        ++j;
+      }
+
+      sql.append(" VALUES(");
+
+      for (int i{}; i != n; ++i)
+      {
+        sql.append(i ? ",?" : "?");
+      }
+
+      sql.push_back(')');
+
+      // a missing table is a runtime error here, not a failed assert
+      sqlite3_stmt* p;
+
+      if (SQLITE_OK != (r = sqlite3_prepare_v3(db, sql.data(), sql.size(),
+        SQLITE_PREPARE_PERSISTENT, &p, nullptr)))
+      {
+        break;
+      }
+
+      s.reset(p);
+      r = SQLITE_DONE;
+    }
+
+    for (auto const m(b->size()); j != m; ++j)
+    {
+      if (autocommit && !pending &&
+        (SQLITE_OK != (r = sqlite3_exec(db, "BEGIN", {}, {}, {}))))
+      {
+        break;
+      }
+
+      auto const fb(b->records[j]);
+      auto const fe(std::min(b->records[j + 1], fb + n));
+
+      r = sqlite3_reset(s.get());
+
+      for (auto k(fb); (SQLITE_OK == r) && (k != fe); ++k)
+      {
+        auto const i(int(k - fb));
+
+        r = detail::bind_field(s.get(), i + 1,
+          std::size_t(i) < o.types.size() ? o.types[i] : AS_TEXT,
+          o.empty_is_null,
+          b->data.data() + b->fields[k].first,
+          b->fields[k].second - b->fields[k].first);
+      }
+
+      // missing trailing fields are NULL
+      for (auto i(int(fe - fb)); i != n; ++i)
+      {
+        sqlite3_bind_null(s.get(), i + 1);
+      }
+
+      if ((SQLITE_OK != r) || (SQLITE_DONE != (r = exec(s))))
+      {
+        break;
+      }
+
+      ++imported;
+
+      if (autocommit && (++pending == o.commit_rows))
+      {
+        if (SQLITE_OK != (r = sqlite3_exec(db, "COMMIT", {}, {}, {})))
+        {
+          break;
+        }
+        else
+        {
+          pending = 0;
+          r = SQLITE_DONE;
+        }
+      }
+    }
+
+    if (s)
+    {
+      sqlite3_reset(s.get());
+      sqlite3_clear_bindings(s.get());
+    }
+
+    if ((SQLITE_DONE != r) || !empty.push(std::move(b)))
+    {
+      break;
+    }
+  }
+
+  full.close();
+  empty.close();
+
+  parser.join();
+
+  if (pending)
+  {
+    if (SQLITE_DONE == r)
+    {
+      if (auto const c(sqlite3_exec(db, "COMMIT", {}, {}, {}));
+        SQLITE_OK != c)
+      {
+        r = c;
+      }
+    }
+    else
+    {
+      sqlite3_exec(db, "ROLLBACK", {}, {}, {});
+
+      imported -= pending;
+    }
+  }
+
+  return {r, imported};
+}
+
+template <typename D, typename ...A, typename = std::enable_if_t<is_db_v<D>>>
+inline auto import_csv(D const& db, A&& ...args)
+{
+  return import_csv(db.get(), std::forward<A>(args)...);
+}
+#endif // SQU_ENABLE_IMPORT_CSV
+
+
+//hooks///////////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_RESULT_CACHE) || defined(SQU_ENABLE_CHANGE_STREAM) || \
+  defined(SQU_ENABLE_RECORDER)
+namespace detail
+{
+
+// a connection has a single commit hook, rollback hook and trace callback,
+// the components attached to it share them through this, a hook the
+// application installed beforehand trips an assertion
+class hooks
+{
+public:
+  struct subscriber
+  {
+    void* p;
+    void const* owner;
+
+    int (*commit)(void*) noexcept;
+    void (*rollback)(void*) noexcept;
+
+    // a statement has finished, with its duration in ns
+    void (*profile)(void*, sqlite3_stmt*, sqlite3_int64) noexcept;
+  };
+
+private:
+  std::vector<subscriber> s_;
+
+  static inline std::mutex m_;
+  static inline std::unordered_map<sqlite3*, std::unique_ptr<hooks>> all_;
+
+  // every subscriber sees the commit, any of them may turn it into a
+  // rollback
+  static int commit(void* const p) noexcept
+  {
+    int r{};
+
+    for (auto& s: static_cast<hooks*>(p)->s_)
+    {
+      if (s.commit)
+      {
+        r |= s.commit(s.p);
+      }
+    }
+
+    return r;
+  }
+
+  static void rollback(void* const p) noexcept
+  {
+    for (auto& s: static_cast<hooks*>(p)->s_)
+    {
+      if (s.rollback)
+      {
+        s.rollback(s.p);
+      }
+    }
+  }
+
+  static int trace(unsigned, void* const p, void* const stmt,
+    void* const x) noexcept
+  {
+    for (auto& s: static_cast<hooks*>(p)->s_)
+    {
+      if (s.profile)
+      {
+        s.profile(s.p, static_cast<sqlite3_stmt*>(stmt),
+          *static_cast<sqlite3_int64 const*>(x));
+      }
+    }
+
+    return 0;
+  }
+
+public:
+  // subscribers are called in the order they subscribed, on the thread
+  // stepping the connection, whose mutex guards their list
+  static void subscribe(sqlite3* const db, subscriber const& s)
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    if (auto const i(all_.find(db)); all_.end() == i)
+    {
+      auto h(std::make_unique<hooks>());
+      h->s_.push_back(s);
+
+      auto const p(all_.emplace(db, std::move(h)).first->second.get());
+
+      [[maybe_unused]] auto const c(sqlite3_commit_hook(db, &commit, p));
+      [[maybe_unused]] auto const r(sqlite3_rollback_hook(db, &rollback, p));
+      assert(!c && !r);
+
+      sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, &trace, p);
+    }
+    else
+    {
+      auto& v(i->second->s_);
+      v.reserve(v.size() + 1);
+
+      auto const m(sqlite3_db_mutex(db));
+
+      sqlite3_mutex_enter(m);
+      v.push_back(s);
+      sqlite3_mutex_leave(m);
+    }
+  }
+
+  // drop the subscriptions of owner, the hooks are removed with the last
+  static void unsubscribe(sqlite3* const db, void const* const owner)
+    noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    if (auto const i(all_.find(db)); all_.end() != i)
+    {
+      auto& v(i->second->s_);
+
+      auto const m(sqlite3_db_mutex(db));
+
+      sqlite3_mutex_enter(m);
+      v.erase(std::remove_if(v.begin(), v.end(),
+        [owner](auto& s) noexcept { return owner == s.owner; }), v.end());
+      sqlite3_mutex_leave(m);
+
+      if (v.empty())
+      {
+        sqlite3_commit_hook(db, nullptr, nullptr);
+        sqlite3_rollback_hook(db, nullptr, nullptr);
+        sqlite3_trace_v2(db, 0, nullptr, nullptr);
+
+        all_.erase(i);
+      }
+    }
+  }
+};
+
+}
+#endif // SQU_ENABLE_RESULT_CACHE || CHANGE_STREAM || RECORDER
+
+
+//result_cache////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_RESULT_CACHE)
+namespace detail
+{
+
+template <typename T>
+inline char const type_tag{};
+
+template <typename T>
+struct is_cacheable :
+  std::integral_constant<
+    bool,
+    std::is_arithmetic_v<T> ||
+    std::is_same_v<T, std::string> ||
+    std::is_same_v<T, std::u16string>
+  >
+{
+};
+
+template <typename A, typename B>
+struct is_cacheable<std::pair<A, B>> :
+  std::integral_constant<bool, is_cacheable<A>{} && is_cacheable<B>{}>
+{
+};
+
+template <typename ...A>
+struct is_cacheable<std::tuple<A...>> :
+  std::integral_constant<bool, (is_cacheable<A>{} && ...)>
+{
+};
+
+template <typename T>
+inline std::size_t cached_bytes(T const& v) noexcept
+{
+  if constexpr (std::is_same_v<T, std::string> ||
+    std::is_same_v<T, std::u16string>)
+  {
+    return sizeof(v) + v.capacity() * sizeof(typename T::value_type);
+  }
+  else if constexpr (is_std_pair<T>{} || is_std_tuple<T>{})
+  {
+    return std::apply([](auto const& ...a) noexcept
+      {
+        return (cached_bytes(a) + ... + std::size_t());
+      },
+      v
+    );
+  }
+  else
+  {
+    return sizeof(v);
+  }
+}
+
+inline void append_key(std::string& k, void const* const p,
+  std::size_t const n)
+{
+  k.append(reinterpret_cast<char const*>(&n), sizeof(n));
+  k.append(static_cast<char const*>(p), n);
+}
+
+// bound values are serialized with a type prefix, so that 1 and '1' differ
+template <typename T>
+inline void append_key(std::string& k, T const& v)
+{
+  using U = remove_cvr_t<T>;
+
+  if constexpr (std::is_same_v<U, std::nullptr_t>)
+  {
+    k.push_back('0');
+  }
+  else if constexpr (std::is_arithmetic_v<U>)
+  {
+    k.push_back(std::is_floating_point_v<U> ? 'f' : 'i');
+    k.append(reinterpret_cast<char const*>(&v), sizeof(v));
+  }
+  else if constexpr (std::is_convertible_v<U const&, std::string_view>)
+  {
+    std::string_view const sv(v);
+
+    k.push_back('t');
+    append_key(k, sv.data(), sv.size());
+  }
+  else if constexpr (std::is_convertible_v<U const&, std::u16string_view>)
+  {
+    std::u16string_view const sv(v);
+
+    k.push_back('u');
+    append_key(k, sv.data(), sv.size() * sizeof(char16_t));
+  }
+  else if constexpr (is_charpair<U>{})
+  {
+    k.push_back('t');
+    append_key(k, v.first, v.first ? v.second : 0);
+  }
+  else if constexpr (is_char16pair<U>{})
+  {
+    k.push_back('u');
+    append_key(k, v.first, v.first ? v.second * sizeof(char16_t) : 0);
+  }
+  else
+  {
+    static_assert(std::is_same_v<U, blobpair<STATIC>> ||
+      std::is_same_v<U, blobpair<TRANSIENT>>, "unsupported key type");
+
+    // a zeroblob
+    k.push_back(v.first ? 'b' : 'z');
+    v.first ?
+      append_key(k, v.first, v.second) :
+      append_key(k, &v.second, sizeof(v.second));
+  }
+}
+
+}
+
+namespace detail
+{
+
+// an id per database of db, the file name, or the connection for temporary
+// and in-memory databases, which no other connection can see
+inline std::string database_id(sqlite3* const db, char const* const name)
+{
+  if (auto const f(sqlite3_db_filename(db, name)); f && *f)
+  {
+    return f;
+  }
+  else
+  {
+    std::string r(1, '\0');
+    r.append(reinterpret_cast<char const*>(&db), sizeof(db));
+
+    return r.append(name);
+  }
+}
+
+}
+
+class result_cache
+{
+  using files_t = std::vector<std::string>;
+
+  struct entry
+  {
+    std::any value;
+    std::size_t bytes;
+
+    std::shared_ptr<files_t const> files;
+
+    std::list<std::string_view>::iterator lru;
+  };
+
+  struct attachment
+  {
+    result_cache* c;
+    sqlite3* db;
+
+    // a commit has begun, but the statement running it has not finished
+    bool committing;
+  };
+
+  std::size_t const max_bytes_;
+
+  mutable std::mutex m_;
+
+  std::unordered_map<std::string, entry> entries_;
+  std::list<std::string_view> lru_;
+  std::size_t bytes_{};
+
+  // database files read by a statement, keyed by connection and sql, a null
+  // pointer for statements that may not be cached
+  std::unordered_map<std::string, std::shared_ptr<files_t const>> deps_;
+
+  std::unordered_map<std::string,
+    std::unordered_set<std::string_view>> by_file_;
+
+  // bumped on every invalidation, results computed across a bump are not
+  // stored
+  std::uint64_t generation_{};
+
+  std::list<attachment> attachments_;
+
+  std::uint64_t hits_{};
+  std::uint64_t misses_{};
+
+  // index sets are pruned when they empty, unless an invalidation is
+  // walking them
+  void erase(std::unordered_map<std::string, entry>::iterator const i,
+    bool const prune = true) noexcept
+  {
+    std::string_view const k(i->first);
+    auto& e(i->second);
+
+    for (auto& f: *e.files)
+    {
+      if (auto const j(by_file_.find(f)); by_file_.end() != j)
+      {
+        if (j->second.erase(k); prune && j->second.empty())
+        {
+          by_file_.erase(j);
+        }
+      }
+    }
+
+    lru_.erase(e.lru);
+    bytes_ -= e.bytes;
+
+    entries_.erase(i);
+  }
+
+  void invalidate_locked(sqlite3* const db) noexcept
+  {
+    ++generation_;
+
+    char const* n;
+
+    for (int i{}; (n = sqlite3_db_name(db, i)); ++i)
+    {
+      if (auto const j(by_file_.find(detail::database_id(db, n)));
+        by_file_.end() != j)
+      {
+        for (auto& c(j->second); !c.empty();)
+        {
+          erase(entries_.find(std::string(*c.begin())), false);
+        }
+
+        by_file_.erase(j);
+      }
+    }
+  }
+
+  // functions whose result is not fixed by their arguments, the date and
+  // time functions among them, as they may read the clock, functions the
+  // application defines are taken to be deterministic
+  static bool volatile_function(std::string_view const p4) noexcept
+  {
+    static constexpr std::string_view names[]{
+      "changes", "current_date", "current_time", "current_timestamp",
+      "date", "datetime", "julianday", "last_insert_rowid", "random",
+      "randomblob", "strftime", "time", "timediff", "total_changes",
+      "unixepoch"
+    };
+
+    // p4 is the name followed by the argument count, e.g. random(0)
+    auto const n(p4.substr(0, p4.find('(')));
+
+    return std::find(std::begin(names), std::end(names), n) !=
+      std::end(names);
+  }
+
+  // statements reading virtual tables, or no table at all, or calling
+  // volatile functions, e.g. random() or datetime('now'), are not cached
+  static std::shared_ptr<files_t const> files_read(sqlite3_stmt* const s)
+  {
+    auto const db(sqlite3_db_handle(s));
+
+    std::string sql("EXPLAIN ");
+    sql.append(sqlite3_sql(s));
+
+    sqlite3_stmt* e;
+
+    if (SQLITE_OK != sqlite3_prepare_v2(db, sql.c_str(), -1, &e, nullptr))
+    {
+      return {};
+    }
+
+    unique_stmt_t const ue(e);
+
+    files_t r;
+    bool cacheable(true);
+
+    // addr, opcode, p1, p2, p3, p4
+    foreach_row(ue,
+      [&](std::string_view const& op, int, int, int const p3,
+        std::string_view const& p4)
+      {
+        if (("Function" == op.substr(0, 8) ||
+          "PureFunc" == op.substr(0, 8)) && volatile_function(p4))
+        {
+          cacheable = false;
+        }
+        else if ("OpenRead" == op)
+        {
+          if (auto const n(sqlite3_db_name(db, p3)); n)
+          {
+            r.emplace_back(detail::database_id(db, n));
+          }
+          else
+          {
+            cacheable = false;
+          }
+        }
+        else if ("VOpen" == op)
+        {
+          cacheable = false;
+        }
+      },
+      1
+    );
+
+    std::sort(r.begin(), r.end());
+    r.erase(std::unique(r.begin(), r.end()), r.end());
+
+    return cacheable && !r.empty() ?
+      std::make_shared<files_t const>(std::move(r)) :
+      std::shared_ptr<files_t const>();
+  }
+
+  // fires for every write transaction, whatever it changed, including
+  // schema changes and deletes the update hook never sees, but before the
+  // commit is durable, so that a reader may still see the old snapshot and
+  // store what it read under the new generation
+  static int commit_hook(void* const p) noexcept
+  {
+    auto& a(*static_cast<attachment*>(p));
+
+    std::lock_guard<std::mutex> l(a.c->m_);
+
+    a.c->invalidate_locked(a.db);
+    a.committing = true;
+
+    return 0;
+  }
+
+  // the statement that committed has finished, so invalidate again, failed
+  // commits roll back, unless they failed with SQLITE_BUSY, which leaves
+  // the connection inside the transaction
+  static void profile(void* const p, sqlite3_stmt*, sqlite3_int64) noexcept
+  {
+    if (auto& a(*static_cast<attachment*>(p));
+      a.committing && sqlite3_get_autocommit(a.db))
+    {
+      std::lock_guard<std::mutex> l(a.c->m_);
+
+      a.c->invalidate_locked(a.db);
+      a.committing = false;
+    }
+  }
+
+public:
+  // at most max_deps statements have their dependencies remembered
+  static constexpr std::size_t max_deps{std::size_t(1) << 12};
+
+  explicit result_cache(std::size_t const max_bytes =
+    std::size_t(16) << 20) noexcept :
+    max_bytes_(max_bytes)
+  {
+  }
+
+  result_cache(result_cache const&) = delete;
+
+  result_cache& operator=(result_cache const&) = delete;
+
+  // hook the commits of a writing connection, which must be detached before
+  // *this is destroyed; the commit hook and trace callback of db are shared
+  // with the other components of this library, but not with hooks of the
+  // application; changes made through connections that are not attached
+  // must be followed by invalidate()
+  void attach(sqlite3* const db)
+  {
+    auto& a([&]() -> auto&
+      {
+        std::lock_guard<std::mutex> l(m_);
+
+        return attachments_.emplace_back(attachment{this, db, {}});
+      }()
+    );
+
+    detail::hooks::subscribe(db,
+      {&a, this, &result_cache::commit_hook, {}, &result_cache::profile});
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  void attach(D const& db)
+  {
+    attach(db.get());
+  }
+
+  void detach(sqlite3* const db) noexcept
+  {
+    detail::hooks::unsubscribe(db, this);
+
+    std::lock_guard<std::mutex> l(m_);
+
+    attachments_.remove_if([db](auto& a) noexcept { return db == a.db; });
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  void detach(D const& db) noexcept
+  {
+    detach(db.get());
+  }
+
+  // drop every result read from any of the databases of db
+  void invalidate(sqlite3* const db) noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    invalidate_locked(db);
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  void invalidate(D const& db) noexcept
+  {
+    invalidate(db.get());
+  }
+
+  void clear() noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    ++generation_;
+
+    entries_.clear();
+    lru_.clear();
+    by_file_.clear();
+    deps_.clear();
+
+    bytes_ = 0;
+  }
+
+  auto bytes() const noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    return bytes_;
+  }
+
+  auto size() const noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    return entries_.size();
+  }
+
+  auto hits() const noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    return hits_;
+  }
+
+  auto misses() const noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    return misses_;
+  }
+
+  // the memoized value of column i of s, f() returns the result code of the
+  // step and the value, only results of calls binding every parameter of s,
+  // starting at 1, and not inside a transaction, whose snapshot may be older
+  // or newer than that of the cache, are memoized
+  template <typename T, int I, typename F, typename ...A>
+  std::optional<T> get(sqlite3_stmt* const s, int const i, F const f,
+    A const& ...args)
+  {
+    static_assert(detail::is_cacheable<T>{},
+      "cached results must own their data");
+
+    auto const db(sqlite3_db_handle(s));
+
+    // statements with side effects are never cached
+    if ((1 != I) || (int(sizeof...(A)) != sqlite3_bind_parameter_count(s)) ||
+      !sqlite3_stmt_readonly(s) || !sqlite3_get_autocommit(db))
+    {
+      return f().second;
+    }
+
+    // the same sql may read different databases on different connections
+    std::string k;
+
+    {
+      char const* n;
+
+      for (int j{}; (n = sqlite3_db_name(db, j)); ++j)
+      {
+        auto const id(detail::database_id(db, n));
+        detail::append_key(k, id.data(), id.size());
+      }
+    }
+
+    k.append(sqlite3_sql(s)).push_back('\0');
+
+    auto const dk(k.size());
+
+    {
+      auto const t(&detail::type_tag<T>);
+      k.append(reinterpret_cast<char const*>(&t), sizeof(t));
+    }
+
+    k.append(reinterpret_cast<char const*>(&i), sizeof(i));
+    (detail::append_key(k, args), ...);
+
+    std::unique_lock<std::mutex> l(m_);
+
+    if (auto const j(entries_.find(k)); entries_.end() != j)
+    {
+      ++hits_;
+
+      auto& e(j->second);
+      lru_.splice(lru_.begin(), lru_, e.lru);
+
+      return *std::any_cast<std::optional<T>>(&e.value);
+    }
+
+    ++misses_;
+
+    auto const g(generation_);
+
+    std::shared_ptr<files_t const> d;
+
+    if (auto const j(deps_.find(k.substr(0, dk))); deps_.end() != j)
+    {
+      d = j->second;
+    }
+    else
+    {
+      l.unlock();
+
+      d = files_read(s);
+
+      l.lock();
+
+      if (deps_.size() >= max_deps)
+      {
+        deps_.clear();
+      }
+
+      deps_.emplace(k.substr(0, dk), d);
+    }
+
+    l.unlock();
+
+    auto [rc, r](f());
+
+    l.lock();
+
+    // errors, such as SQLITE_BUSY, are not results
+    if ((SQLITE_ROW == rc) || (SQLITE_DONE == rc))
+    {
+      if (d && (g == generation_))
+      {
+        entry e{r, k.size() + 2 * sizeof(void*) + sizeof(entry) +
+          (r ? detail::cached_bytes(*r) : 0), d, {}};
+
+        if (e.bytes <= max_bytes_)
+        {
+          while (bytes_ + e.bytes > max_bytes_)
+          {
+            erase(entries_.find(std::string(lru_.back())));
+          }
+
+          if (auto const [j, inserted](entries_.emplace(std::move(k),
+            std::move(e))); inserted)
+          {
+            std::string_view const sv(j->first);
+            auto& ne(j->second);
+
+            lru_.push_front(sv);
+            ne.lru = lru_.begin();
+            bytes_ += ne.bytes;
+
+            for (auto& fl: *ne.files)
+            {
+              by_file_[fl].insert(sv);
+            }
+          }
+        }
+      }
+    }
+
+    return r;
+  }
+};
+
+// cached variants of execget and rexecget, the statement is reset after a
+// miss, so that it does not keep a read transaction open
+namespace detail
+{
+
+inline auto stmt_ptr(sqlite3_stmt* const s) noexcept
+{
+  return s;
+}
+
+template <typename S, typename = std::enable_if_t<is_stmt_v<S>>>
+inline auto stmt_ptr(S const& s) noexcept
+{
+  return s.get();
+}
+
+}
+
+template <typename T, int I = 1, typename S, typename ...A>
+inline auto cached_execget(result_cache& c, S&& s, int const i = 0,
+  A&& ...args)
+{
+  auto const p(detail::stmt_ptr(s));
+
+  return c.get<T, I>(p, i, [&]()
+    {
+      auto const r(exec<I>(p, std::forward<A>(args)...));
+
+      std::pair<int, std::optional<T>> v(r, SQLITE_ROW == r ?
+        std::optional<T>(get<T>(p, i)) : std::optional<T>());
+      sqlite3_reset(p);
+
+      return v;
+    },
+    args...
+  );
+}
+
+template <typename T, int I = 1, typename S, typename ...A>
+inline auto cached_rexecget(result_cache& c, S&& s, int const i = 0,
+  A&& ...args)
+{
+  auto const p(detail::stmt_ptr(s));
+
+  return c.get<T, I>(p, i, [&]()
+    {
+      auto const r(rexec<I>(p, std::forward<A>(args)...));
+
+      std::pair<int, std::optional<T>> v(r, SQLITE_ROW == r ?
+        std::optional<T>(get<T>(p, i)) : std::optional<T>());
+      sqlite3_reset(p);
+
+      return v;
+    },
+    args...
+  );
+}
+#endif // SQU_ENABLE_RESULT_CACHE
+
+
+//ring_buffer/////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_CHANGE_STREAM)
+// bounded lock-free queue, safe for any number of producers and consumers
+template <typename T>
+class ring_buffer
+{
+  struct cell
+  {
+    std::atomic<std::size_t> seq;
+    T v;
+  };
+
+  std::size_t const mask_;
+  std::unique_ptr<cell[]> const cells_;
+
+  alignas(64) std::atomic<std::size_t> head_{};
+  alignas(64) std::atomic<std::size_t> tail_{};
+
+  static std::size_t round_up(std::size_t const n) noexcept
+  {
+    std::size_t r(2);
+
+    while (r < n)
+    {
+      r <<= 1;
+    }
+
+    return r;
+  }
+
+public:
+  // capacity is rounded up to a power of 2
+  explicit ring_buffer(std::size_t const capacity) :
+    mask_(round_up(capacity) - 1),
+    cells_(new cell[mask_ + 1])
+  {
+    for (std::size_t i{}; i <= mask_; ++i)
+    {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ring_buffer(ring_buffer const&) = delete;
+
+  ring_buffer& operator=(ring_buffer const&) = delete;
+
+  auto capacity() const noexcept
+  {
+    return mask_ + 1;
+  }
+
+  // approximate while producers or consumers are active
+  std::size_t size() const noexcept
+  {
+    auto const t(tail_.load(std::memory_order_relaxed));
+    auto const h(head_.load(std::memory_order_relaxed));
+
+    return h > t ? h - t : 0;
+  }
+
+  template <typename U>
+  bool try_push(U&& v) noexcept(std::is_nothrow_assignable_v<T&, U&&>)
+  {
+    auto h(head_.load(std::memory_order_relaxed));
+
+    for (;;)
+    {
+      auto& c(cells_[h & mask_]);
+
+      if (auto const d(std::intptr_t(c.seq.load(std::memory_order_acquire)) -
+        std::intptr_t(h)); !d)
+      {
+        if (head_.compare_exchange_weak(h, h + 1, std::memory_order_relaxed))
+        {
+          c.v = std::forward<U>(v);
+          c.seq.store(h + 1, std::memory_order_release);
+
+          return true;
+        }
+      }
+      else if (d < 0)
+      {
+        // full
+        return false;
+      }
+      else
+      {
+        h = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool try_pop(T& v) noexcept(std::is_nothrow_move_assignable_v<T>)
+  {
+    auto t(tail_.load(std::memory_order_relaxed));
+
+    for (;;)
+    {
+      auto& c(cells_[t & mask_]);
+
+      if (auto const d(std::intptr_t(c.seq.load(std::memory_order_acquire)) -
+        std::intptr_t(t + 1)); !d)
+      {
+        if (tail_.compare_exchange_weak(t, t + 1, std::memory_order_relaxed))
+        {
+          v = std::move(c.v);
+          c.seq.store(t + mask_ + 1, std::memory_order_release);
+
+          return true;
+        }
+      }
+      else if (d < 0)
+      {
+        // empty
+        return false;
+      }
+      else
+      {
+        t = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+};
+#endif // SQU_ENABLE_CHANGE_STREAM
+
+//value///////////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_CHANGE_STREAM) || \
+  (defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK))
+// a column value of a change
+using value = std::variant<
+  std::nullptr_t,
+  sqlite3_int64,
+  double,
+  std::string,
+  std::vector<unsigned char>
+>;
+
+namespace detail
+{
+
+inline value make_value(sqlite3_value* const v)
+{
+  switch (sqlite3_value_type(v))
+  {
+    case SQLITE_INTEGER:
+      return sqlite3_value_int64(v);
+
+    case SQLITE_FLOAT:
+      return sqlite3_value_double(v);
+
+    case SQLITE_TEXT:
+    {
+      auto const p(reinterpret_cast<char const*>(sqlite3_value_text(v)));
+
+      return std::string(p, std::size_t(sqlite3_value_bytes(v)));
+    }
+
+    case SQLITE_BLOB:
+    {
+      auto const p(static_cast<unsigned char const*>(sqlite3_value_blob(v)));
+
+      return std::vector<unsigned char>(p,
+        p + std::size_t(sqlite3_value_bytes(v)));
+    }
+
+    default:
+      return nullptr;
+  }
+}
+
+}
+#endif // SQU_ENABLE_CHANGE_STREAM || SQLITE_ENABLE_SESSION
+
+
+//sql_token///////////////////////////////////////////////////////////////////
+// a tokenizer good enough to find keywords, names and parameters in sql
+namespace detail
+{
+
+enum sql_token_kind
+{
+  TK_END,
+  TK_PUNCT,
+  TK_WORD,
+  TK_STRING,
+  TK_ID,
+  TK_PARAM
+};
+
+struct sql_token
+{
+  sql_token_kind kind;
+
+  std::size_t begin;
+  std::size_t end;
+};
+
+constexpr bool is_space(char const c) noexcept
+{
+  return (' ' == c) || ('\t' == c) || ('\n' == c) || ('\r' == c) ||
+    ('\f' == c) || ('\v' == c);
+}
+
+constexpr bool is_digit(char const c) noexcept
+{
+  return (c >= '0') && (c <= '9');
+}
+
+constexpr bool is_ident(char const c) noexcept
+{
+  return is_digit(c) || ((c >= 'a') && (c <= 'z')) ||
+    ((c >= 'A') && (c <= 'Z')) || ('_' == c) || ('$' == c) ||
+    (static_cast<unsigned char>(c) >= 0x80);
+}
+
+// the token starting at or after i, comments and whitespace are skipped
+constexpr sql_token next_token(std::string_view const s, std::size_t i)
+  noexcept
+{
+  for (auto const n(s.size());;)
+  {
+    while ((i != n) && is_space(s[i]))
+    {
+      ++i;
+    }
+
+    if ((i + 1 < n) && ('-' == s[i]) && ('-' == s[i + 1]))
+    {
+      while ((i != n) && ('\n' != s[i]))
+      {
+        ++i;
+      }
+    }
+    else if ((i + 1 < n) && ('/' == s[i]) && ('*' == s[i + 1]))
+    {
+      for (i += 2; (i != n) && !(('*' == s[i - 1]) && ('/' == s[i])); ++i);
+
+      i += i != n;
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  auto const b(i);
+
+  if (i == s.size())
+  {
+    return {TK_END, b, b};
+  }
+
+  switch (auto const c(s[i++]); c)
+  {
+    case '\'':
+    case '"':
+    case '`':
+    case '[':
+      // doubled quotes escape quotes, which the loop takes as two literals
+      for (auto const q('[' == c ? ']' : c); (i != s.size()) && (q != s[i++]););
+
+      return {'\'' == c ? TK_STRING : TK_ID, b, i};
+
+    case '?':
+      while ((i != s.size()) && is_digit(s[i]))
+      {
+        ++i;
+      }
+
+      return {TK_PARAM, b, i};
+
+    case ':':
+    case '@':
+    case '$':
+      if ((i != s.size()) && is_ident(s[i]))
+      {
+        while ((i != s.size()) && is_ident(s[i]))
+        {
+          ++i;
+        }
+
+        return {TK_PARAM, b, i};
+      }
+
+      return {TK_PUNCT, b, i};
+
+    default:
+      if (is_ident(c))
+      {
+        // numbers, with their decimal points, are words too
+        while ((i != s.size()) && (is_ident(s[i]) || ('.' == s[i] &&
+          is_digit(c))))
+        {
+          ++i;
+        }
+
+        return {TK_WORD, b, i};
+      }
+
+      return {TK_PUNCT, b, i};
+  }
+}
+
+constexpr bool is_keyword(std::string_view const s, sql_token const& t,
+  std::string_view const k) noexcept
+{
+  if ((TK_WORD != t.kind) || (t.end - t.begin != k.size()))
+  {
+    return false;
+  }
+
+  for (std::size_t i{}; i != k.size(); ++i)
+  {
+    if (auto const c(s[t.begin + i]);
+      (((c >= 'A') && (c <= 'Z')) ? char(c - 'A' + 'a') : c) != k[i])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+constexpr bool is_punct(std::string_view const s, sql_token const& t,
+  char const c) noexcept
+{
+  return (TK_PUNCT == t.kind) && (c == s[t.begin]);
+}
+
+}
+
+//change_stream///////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_CHANGE_STREAM)
+struct change
+{
+  // SQLITE_INSERT, SQLITE_UPDATE or SQLITE_DELETE
+  int op;
+
+  std::string db;
+  std::string table;
+
+  // rowid before and after the change, they differ only for updates of the
+  // rowid itself
+  sqlite3_int64 rowid;
+  sqlite3_int64 new_rowid;
+
+  // column values before and after the change, filled in only when sqlite
+  // has been built with SQLITE_ENABLE_PREUPDATE_HOOK
+  std::vector<value> old_values;
+  std::vector<value> new_values;
+};
+
+// what a committing writer does when the ring is full; BLOCK waits inside
+// the sqlite3_step() that committed, yielding until consumers make room,
+// the transaction is durable by then, but the connection is not released,
+// so a stream without consumers stalls its writers
+enum backpressure
+{
+  BLOCK, // wait for the consumers to make room
+  DROP, // drop the changes that do not fit, counting them
+  ABORT // roll the transaction back, unless all its changes fit
+};
+
+class change_stream
+{
+  struct savepoint
+  {
+    std::string name;
+
+    // the number of changes made before it was opened
+    std::size_t n;
+  };
+
+  struct attachment
+  {
+    change_stream* s;
+    sqlite3* db;
+
+    // changes of the open transaction, the first of those made by the
+    // running statement, and whether it made any of them itself, rather
+    // than through triggers or foreign key actions
+    std::vector<change> pending;
+    std::size_t statement;
+    bool direct;
+
+    // the open savepoints, innermost last
+    std::vector<savepoint> savepoints;
+  };
+
+  ring_buffer<change> ring_;
+
+  enum backpressure const bp_;
+
+  std::atomic<std::uint64_t> dropped_{};
+  std::atomic<std::uint64_t> aborted_{};
+  std::atomic<std::uint64_t> lost_{};
+
+  std::mutex m_;
+  std::list<attachment> attachments_;
+
+  // runs before the commit is durable, which may still fail, the changes
+  // are published only once the statement that committed has finished
+  static int commit_hook(void* const p) noexcept
+  {
+    auto& a(*static_cast<attachment*>(p));
+    auto& s(*a.s);
+
+    if ((ABORT == s.bp_) &&
+      (a.pending.size() > s.ring_.capacity() - s.ring_.size()))
+    {
+      s.aborted_.fetch_add(1, std::memory_order_relaxed);
+
+      // turns the commit into a rollback
+      return 1;
+    }
+
+    return 0;
+  }
+
+  static void rollback_hook(void* const p) noexcept
+  {
+    auto& a(*static_cast<attachment*>(p));
+
+    a.pending.clear();
+    a.savepoints.clear();
+
+    a.statement = 0;
+  }
+
+  // SAVEPOINT, RELEASE and ROLLBACK TO, inside a transaction they undo
+  // changes without the rollback hook firing, names are matched without
+  // regard to case, as sqlite matches them
+  static void track_savepoint(attachment& a, std::string_view const sql)
+  {
+    enum { OPEN, RELEASE, ROLLBACK_TO } op;
+
+    auto t(detail::next_token(sql, 0));
+
+    auto const skip([&](char const* const k) noexcept
+      {
+        if (detail::is_keyword(sql, t, k))
+        {
+          t = detail::next_token(sql, t.end);
+
+          return true;
+        }
+
+        return false;
+      }
+    );
+
+    if (skip("savepoint"))
+    {
+      op = OPEN;
+    }
+    else if (skip("release"))
+    {
+      skip("savepoint");
+      op = RELEASE;
+    }
+    else if (skip("rollback"))
+    {
+      skip("transaction");
+
+      if (!skip("to"))
+      {
+        return;
+      }
+
+      skip("savepoint");
+      op = ROLLBACK_TO;
+    }
+    else
+    {
+      return;
+    }
+
+    std::string name;
+
+    if ((detail::TK_ID == t.kind) || (detail::TK_STRING == t.kind))
+    {
+      name = sql.substr(t.begin + 1, t.end - t.begin - 2);
+    }
+    else if (detail::TK_WORD == t.kind)
+    {
+      name = sql.substr(t.begin, t.end - t.begin);
+    }
+    else
+    {
+      return;
+    }
+
+    for (auto& c: name)
+    {
+      c = (c >= 'A') && (c <= 'Z') ? char(c - 'A' + 'a') : c;
+    }
+
+    if (OPEN == op)
+    {
+      a.savepoints.push_back({std::move(name), a.pending.size()});
+    }
+    else if (auto const i(std::find_if(a.savepoints.rbegin(),
+      a.savepoints.rend(), [&](auto& sp) noexcept { return name == sp.name; }));
+      a.savepoints.rend() != i)
+    {
+      if (RELEASE == op)
+      {
+        a.savepoints.erase(std::prev(i.base()), a.savepoints.end());
+      }
+      else
+      {
+        a.pending.erase(a.pending.begin() + i->n, a.pending.end());
+        a.savepoints.erase(i.base(), a.savepoints.end());
+      }
+    }
+  }
+
+  // a statement has finished, if it committed, the transaction has ended,
+  // failed commits roll back, unless they failed with SQLITE_BUSY, which
+  // leaves the connection inside the transaction
+  static void profile(void* const p, sqlite3_stmt* const st, sqlite3_int64)
+    noexcept
+  {
+    auto& a(*static_cast<attachment*>(p));
+    auto& s(*a.s);
+
+    // a statement that failed inside a transaction is undone on its own,
+    // sqlite then reports that it changed no rows, statements reset before
+    // they were done have not failed, but report no changes yet
+    if (a.direct && !sqlite3_changes(a.db) && !sqlite3_stmt_busy(st))
+    {
+      a.pending.erase(a.pending.begin() + a.statement, a.pending.end());
+    }
+
+    if (auto const sql(sqlite3_sql(st)); sql)
+    {
+      try
+      {
+        track_savepoint(a, sql);
+      }
+      catch (...)
+      {
+        // running out of memory costs us the savepoint, a rollback to it
+        // then goes unnoticed
+      }
+    }
+
+    if (!a.pending.empty() && sqlite3_get_autocommit(a.db))
+    {
+      for (auto& c: a.pending)
+      {
+        // the room for ABORT was checked while committing
+        while (!s.ring_.try_push(std::move(c)))
+        {
+          if (DROP == s.bp_)
+          {
+            s.dropped_.fetch_add(1, std::memory_order_relaxed);
+
+            break;
+          }
+          else
+          {
+            std::this_thread::yield();
+          }
+        }
+      }
+
+      a.pending.clear();
+      a.savepoints.clear();
+    }
+
+    a.statement = a.pending.size();
+    a.direct = false;
+  }
+
+  // running out of memory costs us the change, not the statement
+#if defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+  static void preupdate_hook(void* const p, sqlite3* const db, int const op,
+    char const* const zdb, char const* const table, sqlite3_int64 const k1,
+    sqlite3_int64 const k2) noexcept
+  {
+    auto& a(*static_cast<attachment*>(p));
+
+    try
+    {
+      change c{op, zdb, table, k1, SQLITE_INSERT == op ? k1 : k2, {}, {}};
+
+      auto const n(sqlite3_preupdate_count(db));
+
+      if (SQLITE_INSERT != op)
+      {
+        c.old_values.reserve(n);
+
+        for (int i{}; i != n; ++i)
+        {
+          sqlite3_value* v;
+
+          sqlite3_preupdate_old(db, i, &v);
+          c.old_values.emplace_back(detail::make_value(v));
+        }
+      }
+
+      if (SQLITE_DELETE != op)
+      {
+        c.new_values.reserve(n);
+
+        for (int i{}; i != n; ++i)
+        {
+          sqlite3_value* v;
+
+          sqlite3_preupdate_new(db, i, &v);
+          c.new_values.emplace_back(detail::make_value(v));
+        }
+      }
+
+      a.pending.push_back(std::move(c));
+      a.direct |= !sqlite3_preupdate_depth(db);
+    }
+    catch (...)
+    {
+      a.s->lost_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+#else
+  static void update_hook(void* const p, int const op, char const* const zdb,
+    char const* const table, sqlite3_int64 const rowid) noexcept
+  {
+    auto& a(*static_cast<attachment*>(p));
+
+    try
+    {
+      a.pending.push_back(change{op, zdb, table, rowid, rowid, {}, {}});
+
+      // the update hook cannot tell trigger changes apart
+      a.direct = true;
+    }
+    catch (...)
+    {
+      a.s->lost_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+#endif // SQLITE_ENABLE_PREUPDATE_HOOK
+
+public:
+  explicit change_stream(std::size_t const capacity = 1 << 16,
+    enum backpressure const bp = BLOCK) :
+    ring_(capacity),
+    bp_(bp)
+  {
+  }
+
+  change_stream(change_stream const&) = delete;
+
+  change_stream& operator=(change_stream const&) = delete;
+
+  // record the changes made through db, which must be detached before *this
+  // is destroyed; the commit and rollback hooks and the trace callback of db
+  // are shared with the other components of this library, but not with
+  // hooks of the application, the preupdate, or update, hook is taken by
+  // a single change_stream
+  void attach(sqlite3* const db)
+  {
+    auto& a([&]() -> auto&
+      {
+        std::lock_guard<std::mutex> l(m_);
+
+        return attachments_.emplace_back(
+          attachment{this, db, {}, {}, {}, {}});
+      }()
+    );
+
+#if defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+    [[maybe_unused]] auto const u(
+      sqlite3_preupdate_hook(db, &change_stream::preupdate_hook, &a));
+#else
+    [[maybe_unused]] auto const u(
+      sqlite3_update_hook(db, &change_stream::update_hook, &a));
+#endif // SQLITE_ENABLE_PREUPDATE_HOOK
+    assert(!u);
+
+    detail::hooks::subscribe(db, {&a, this, &change_stream::commit_hook,
+      &change_stream::rollback_hook, &change_stream::profile});
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  void attach(D const& db)
+  {
+    attach(db.get());
+  }
+
+  void detach(sqlite3* const db) noexcept
+  {
+#if defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+    sqlite3_preupdate_hook(db, nullptr, nullptr);
+#else
+    sqlite3_update_hook(db, nullptr, nullptr);
+#endif // SQLITE_ENABLE_PREUPDATE_HOOK
+    detail::hooks::unsubscribe(db, this);
+
+    std::lock_guard<std::mutex> l(m_);
+
+    attachments_.remove_if([db](auto& a) noexcept { return db == a.db; });
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  void detach(D const& db) noexcept
+  {
+    detach(db.get());
+  }
+
+  bool try_pop(change& c) noexcept
+  {
+    return ring_.try_pop(c);
+  }
+
+  // pass up to n committed changes to f, returns how many were passed
+  template <typename F>
+  std::size_t drain(F&& f, std::size_t n = -1)
+  {
+    std::size_t r{};
+
+    for (change c; (r != n) && ring_.try_pop(c); ++r)
+    {
+      f(std::move(c));
+    }
+
+    return r;
+  }
+
+  // changes dropped and transactions rolled back because the ring was full
+  auto dropped() const noexcept
+  {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  auto aborted() const noexcept
+  {
+    return aborted_.load(std::memory_order_relaxed);
+  }
+
+  // changes that could not be recorded for want of memory
+  auto lost() const noexcept
+  {
+    return lost_.load(std::memory_order_relaxed);
+  }
+};
+#endif // SQU_ENABLE_CHANGE_STREAM
+
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+//session/////////////////////////////////////////////////////////////////////
+namespace detail
+{
+
+struct sqlite3_session_deleter
+{
+  void operator()(sqlite3_session* const p) const noexcept
+  {
+    sqlite3session_delete(p);
+  }
+};
+
+struct sqlite3_free_deleter
+{
+  void operator()(void* const p) const noexcept
+  {
+    sqlite3_free(p);
+  }
+};
+
+}
+
+using unique_session_t = std::unique_ptr<sqlite3_session,
+  detail::sqlite3_session_deleter
+>;
+
+struct changeset_t
+{
+  std::unique_ptr<void, detail::sqlite3_free_deleter> first;
+  int second;
+};
+
+enum class conflict
+{
+  data = SQLITE_CHANGESET_DATA,
+  notfound = SQLITE_CHANGESET_NOTFOUND,
+  conflict = SQLITE_CHANGESET_CONFLICT,
+  constraint = SQLITE_CHANGESET_CONSTRAINT,
+  foreign_key = SQLITE_CHANGESET_FOREIGN_KEY
+};
+
+enum class resolution
+{
+  omit = SQLITE_CHANGESET_OMIT,
+  replace = SQLITE_CHANGESET_REPLACE,
+  abort = SQLITE_CHANGESET_ABORT
+};
+
+// the change that failed to apply, passed to conflict handlers
+class changeset_conflict
+{
+  sqlite3_changeset_iter* const it_;
+
+  char const* table_;
+  int columns_;
+  int op_;
+  int indirect_;
+
+  template <typename F>
+  auto value(F const f, int const i) const
+  {
+    sqlite3_value* v{};
+
+    return (SQLITE_OK == f(it_, i, &v)) && v ?
+      std::optional<squ::value>(detail::make_value(v)) :
+      std::optional<squ::value>();
+  }
+
+public:
+  enum conflict const type;
+
+  changeset_conflict(enum conflict const t,
+    sqlite3_changeset_iter* const it) noexcept :
+    it_(it),
+    type(t)
+  {
+    sqlite3changeset_op(it_, &table_, &columns_, &op_, &indirect_);
+  }
+
+  auto iter() const noexcept
+  {
+    return it_;
+  }
+
+  std::string_view table() const noexcept
+  {
+    return table_;
+  }
+
+  auto columns() const noexcept
+  {
+    return columns_;
+  }
+
+  // SQLITE_INSERT, SQLITE_UPDATE or SQLITE_DELETE
+  auto op() const noexcept
+  {
+    return op_;
+  }
+
+  bool indirect() const noexcept
+  {
+    return indirect_;
+  }
+
+  // the values of column i the change expects to find, would write and that
+  // are actually in the database, empty where the change does not carry one
+  auto old_value(int const i) const
+  {
+    return value(&sqlite3changeset_old, i);
+  }
+
+  auto new_value(int const i) const
+  {
+    return value(&sqlite3changeset_new, i);
+  }
+
+  auto conflict_value(int const i) const
+  {
+    return value(&sqlite3changeset_conflict, i);
+  }
+};
+
+namespace detail
+{
+
+inline auto make_source(std::FILE* const f) noexcept
+{
+  return [f](void* const p, int& n) noexcept
+    {
+      n = int(std::fread(p, 1, std::size_t(n), f));
+
+      return !std::ferror(f);
+    };
+}
+
+#if __has_include(<unistd.h>)
+inline auto make_source(int const fd) noexcept
+{
+  return [fd](void* const p, int& n) noexcept
+    {
+      for (;;)
+      {
+        if (auto const r(::read(fd, p, std::size_t(n))); r >= 0)
+        {
+          n = int(r);
+
+          return true;
+        }
+        else if (EINTR != errno)
+        {
+          return false;
+        }
+      }
+    };
+}
+#endif
+
+template <typename K>
+inline std::enable_if_t<
+  std::is_invocable_r_v<bool, K&, void*, int&>,
+  K&
+>
+make_source(K& k) noexcept
+{
+  return k;
+}
+
+template <typename K>
+inline int session_output(void* const p, void const* const d,
+  int const n) noexcept
+{
+  return (*static_cast<K*>(p))(static_cast<char const*>(d), std::size_t(n)) ?
+    SQLITE_OK :
+    SQLITE_IOERR_WRITE;
+}
+
+template <typename K>
+inline int session_input(void* const p, void* const d, int* const n)
+  noexcept
+{
+  return (*static_cast<K*>(p))(d, *n) ? SQLITE_OK : SQLITE_IOERR_READ;
+}
+
+// the context argument of the session callbacks, which may be const
+template <typename T>
+inline void* callback_context(T& t) noexcept
+{
+  return const_cast<void*>(static_cast<void const*>(std::addressof(t)));
+}
+
+template <typename F>
+inline int session_conflict(void* const p, int const c,
+  sqlite3_changeset_iter* const it) noexcept
+{
+  return int((*static_cast<F*>(p))(
+    changeset_conflict(static_cast<enum conflict>(c), it)));
+}
+
+// the default handler gives up on the first conflict
+inline auto abort_on_conflict() noexcept
+{
+  return [](changeset_conflict const&) noexcept
+    {
+      return resolution::abort;
+    };
+}
+
+}
+
+//make_session////////////////////////////////////////////////////////////////
+inline auto make_session(sqlite3* const db,
+  char const* const zdb = "main") noexcept
+{
+  sqlite3_session* s;
+
+  auto const r(sqlite3session_create(db, zdb, &s));
+  assert(SQLITE_OK == r);
+
+  return SQLITE_OK == r ? unique_session_t(s) : unique_session_t();
+}
+
+template <typename D, typename ...A, typename = std::enable_if_t<is_db_v<D>>>
+inline auto make_session(D const& db, A&& ...args) noexcept
+{
+  return make_session(db.get(), std::forward<A>(args)...);
+}
+
+//session_attach//////////////////////////////////////////////////////////////
+// record changes to table, or to all tables if it is nullptr
+inline auto session_attach(unique_session_t const& s,
+  char const* const table = nullptr) noexcept
+{
+  return sqlite3session_attach(s.get(), table);
+}
+
+//changeset///////////////////////////////////////////////////////////////////
+inline auto changeset(unique_session_t const& s) noexcept
+{
+  int n;
+  void* p;
+
+  return SQLITE_OK == sqlite3session_changeset(s.get(), &n, &p) ?
+    changeset_t{decltype(changeset_t::first)(p), n} :
+    changeset_t{};
+}
+
+inline auto patchset(unique_session_t const& s) noexcept
+{
+  int n;
+  void* p;
+
+  return SQLITE_OK == sqlite3session_patchset(s.get(), &n, &p) ?
+    changeset_t{decltype(changeset_t::first)(p), n} :
+    changeset_t{};
+}
+
+// stream the changeset to a FILE*, a file descriptor or a
+// bool(char const*, std::size_t) sink, without building it in memory
+template <typename K>
+inline auto changeset_strm(unique_session_t const& s, K&& k) noexcept
+{
+  auto&& sink(detail::make_sink(k));
+
+  return sqlite3session_changeset_strm(s.get(),
+    &detail::session_output<std::remove_reference_t<decltype(sink)>>,
+    detail::callback_context(sink));
+}
+
+template <typename K>
+inline auto patchset_strm(unique_session_t const& s, K&& k) noexcept
+{
+  auto&& sink(detail::make_sink(k));
+
+  return sqlite3session_patchset_strm(s.get(),
+    &detail::session_output<std::remove_reference_t<decltype(sink)>>,
+    detail::callback_context(sink));
+}
+
+//changeset_apply/////////////////////////////////////////////////////////////
+// f is called as resolution(changeset_conflict const&) for every conflict
+template <typename F = decltype(detail::abort_on_conflict())>
+inline auto changeset_apply(sqlite3* const db, void const* const p,
+  int const n, F&& f = detail::abort_on_conflict())
+{
+  return sqlite3changeset_apply(db, n, const_cast<void*>(p), nullptr,
+    &detail::session_conflict<std::remove_reference_t<F>>,
+    detail::callback_context(f));
+}
+
+template <typename ...A>
+inline auto changeset_apply(sqlite3* const db, changeset_t const& c,
+  A&& ...args)
+{
+  return changeset_apply(db, c.first.get(), c.second,
+    std::forward<A>(args)...);
+}
+
+// read the changeset from a FILE*, a file descriptor or a bool(void*, int&)
+// source, which sets its second argument to the number of bytes read
+template <typename K, typename F = decltype(detail::abort_on_conflict())>
+inline auto changeset_apply_strm(sqlite3* const db, K&& k,
+  F&& f = detail::abort_on_conflict())
+{
+  auto&& source(detail::make_source(k));
+
+  return sqlite3changeset_apply_strm(db,
+    &detail::session_input<std::remove_reference_t<decltype(source)>>,
+    detail::callback_context(source),
+    nullptr,
+    &detail::session_conflict<std::remove_reference_t<F>>,
+    detail::callback_context(f));
+}
+
+template <typename D, typename ...A, typename = std::enable_if_t<is_db_v<D>>>
+inline auto changeset_apply(D const& db, A&& ...args)
+{
+  return changeset_apply(db.get(), std::forward<A>(args)...);
+}
+
+template <typename D, typename ...A, typename = std::enable_if_t<is_db_v<D>>>
+inline auto changeset_apply_strm(D const& db, A&& ...args)
+{
+  return changeset_apply_strm(db.get(), std::forward<A>(args)...);
+}
+#endif // SQLITE_ENABLE_SESSION && SQLITE_ENABLE_PREUPDATE_HOOK
+
+
+//explain/////////////////////////////////////////////////////////////////////
+struct plan_node
+{
+  int id;
+  int parent;
+
+  std::string detail;
+
+  // indices of the child nodes
+  std::vector<std::size_t> children;
+};
+
+// the EXPLAIN QUERY PLAN tree of s, parents precede their children and the
+// roots have a parent of 0
+inline std::vector<plan_node> explain(sqlite3_stmt* const s)
+{
+  std::vector<plan_node> r;
+
+  if (auto const sql(sqlite3_sql(s)); sql)
+  {
+    auto const db(sqlite3_db_handle(s));
+
+    sqlite3_stmt* e;
+
+    if (SQLITE_OK == sqlite3_prepare_v2(db,
+      std::string("EXPLAIN QUERY PLAN ").append(sql).c_str(), -1, &e,
+      nullptr))
+    {
+      unique_stmt_t const ue(e);
+
+      std::unordered_map<int, std::size_t> index;
+
+      foreach_row(ue,
+        [&](int const id, int const parent, int, std::string&& detail)
+        {
+          if (auto const i(index.find(parent)); index.end() != i)
+          {
+            r[i->second].children.push_back(r.size());
+          }
+
+          index.emplace(id, r.size());
+          r.push_back({id, parent, std::move(detail), {}});
+        }
+      );
+    }
+  }
+
+  return r;
+}
+
+template <typename S, typename = std::enable_if_t<is_stmt_v<S>>>
+inline auto explain(S const& s)
+{
+  return explain(s.get());
+}
+
+// FULL_SCAN | TEMP_BTREE, define SQU_CHECK_PLANS to have every statement
+// checked as it is prepared
+inline auto check_plan(sqlite3_stmt* const s) noexcept
+{
+  return detail::plan_problems(s);
+}
+
+template <typename S, typename = std::enable_if_t<is_stmt_v<S>>>
+inline auto check_plan(S const& s) noexcept
+{
+  return check_plan(s.get());
+}
+
+#if defined(SQLITE_ENABLE_STMT_SCANSTATUS)
+//scanstatus//////////////////////////////////////////////////////////////////
+struct scan_status
+{
+  // times the loop ran and rows it visited over all runs, the rows a loop
+  // outputs are the runs of the loop nested in it
+  sqlite3_int64 loops;
+  sqlite3_int64 visited;
+
+  // planner estimate of the rows output per run
+  double estimate;
+
+  std::string name;
+  std::string explain;
+
+  int select_id;
+  int parent_id;
+
+  // cpu cycles, 0 unless built with SQLITE_ENABLE_STMT_SCANSTATUS and
+  // SQLITE_SCANSTAT_COMPLEX available
+  sqlite3_int64 cycles;
+};
+
+// per-loop counters of s, accumulated since it was prepared or the counters
+// were last reset
+inline std::vector<scan_status> scanstatus(sqlite3_stmt* const s)
+{
+  std::vector<scan_status> r;
+
+#if defined(SQLITE_SCANSTAT_COMPLEX)
+  auto const get([s](int const i, int const op, void* const p) noexcept
+    {
+      return sqlite3_stmt_scanstatus_v2(s, i, op, SQLITE_SCANSTAT_COMPLEX, p);
+    }
+  );
+#else
+  auto const get([s](int const i, int const op, void* const p) noexcept
+    {
+      return sqlite3_stmt_scanstatus(s, i, op, p);
+    }
+  );
+#endif // SQLITE_SCANSTAT_COMPLEX
+
+  for (int i{};; ++i)
+  {
+    scan_status ss{};
+
+    if (get(i, SQLITE_SCANSTAT_NLOOP, &ss.loops))
+    {
+      break;
+    }
+
+    char const* name{};
+    char const* explain{};
+
+    get(i, SQLITE_SCANSTAT_NVISIT, &ss.visited);
+    get(i, SQLITE_SCANSTAT_EST, &ss.estimate);
+    get(i, SQLITE_SCANSTAT_NAME, &name);
+    get(i, SQLITE_SCANSTAT_EXPLAIN, &explain);
+    get(i, SQLITE_SCANSTAT_SELECTID, &ss.select_id);
+
+#if defined(SQLITE_SCANSTAT_COMPLEX)
+    get(i, SQLITE_SCANSTAT_PARENTID, &ss.parent_id);
+    get(i, SQLITE_SCANSTAT_NCYCLE, &ss.cycles);
+#endif // SQLITE_SCANSTAT_COMPLEX
+
+    ss.name = name ? name : "";
+    ss.explain = explain ? explain : "";
+
+    r.push_back(std::move(ss));
+  }
+
+  return r;
+}
+
+template <typename S, typename = std::enable_if_t<is_stmt_v<S>>>
+inline auto scanstatus(S const& s)
+{
+  return scanstatus(s.get());
+}
+
+inline void scanstatus_reset(sqlite3_stmt* const s) noexcept
+{
+  sqlite3_stmt_scanstatus_reset(s);
+}
+
+template <typename S, typename = std::enable_if_t<is_stmt_v<S>>>
+inline void scanstatus_reset(S const& s) noexcept
+{
+  scanstatus_reset(s.get());
+}
+#endif // SQLITE_ENABLE_STMT_SCANSTATUS
+
+
+//sql/////////////////////////////////////////////////////////////////////////
+namespace detail
+{
+
+// parameter or column count that cannot be determined from the sql alone
+inline constexpr std::size_t unknown_count{std::size_t(-1)};
+
+// the number of parameters of the first statement in s, numbered the way
+// sqlite3_bind_parameter_count() numbers them
+constexpr std::size_t count_params(std::string_view const s) noexcept
+{
+  std::size_t n{};
+
+  for (auto t(next_token(s, 0));
+    (TK_END != t.kind) && !is_punct(s, t, ';');
+    t = next_token(s, t.end))
+  {
+    if (TK_PARAM != t.kind)
+    {
+      continue;
+    }
+    else if ('?' == s[t.begin])
+    {
+      if (1 == t.end - t.begin)
+      {
+        ++n;
+      }
+      else
+      {
+        std::size_t k{};
+
+        for (auto i(t.begin + 1); i != t.end; ++i)
+        {
+          k = 10 * k + std::size_t(s[i] - '0');
+        }
+
+        n = std::max(n, k);
+      }
+    }
+    else
+    {
+      // a named parameter reuses the index of its first occurrence
+      auto const name(s.substr(t.begin, t.end - t.begin));
+
+      auto u(next_token(s, 0));
+
+      while ((u.begin != t.begin) &&
+        ((TK_PARAM != u.kind) || (s.substr(u.begin, u.end - u.begin) != name)))
+      {
+        u = next_token(s, u.end);
+      }
+
+      n += u.begin == t.begin;
+    }
+  }
+
+  return n;
+}
+
+// the number of result columns of the first statement in s, known for plain
+// SELECTs without * and for DML without RETURNING
+constexpr std::size_t count_columns(std::string_view const s) noexcept
+{
+  auto t(next_token(s, 0));
+
+  if (is_keyword(s, t, "select"))
+  {
+    std::size_t n(1);
+    int depth{};
+
+    for (auto p(t); (TK_END != (t = next_token(s, t.end)).kind); p = t)
+    {
+      if (TK_PUNCT == t.kind)
+      {
+        switch (s[t.begin])
+        {
+          case '(':
+            ++depth;
+            break;
+
+          case ')':
+            --depth;
+            break;
+
+          case ',':
+            n += !depth;
+            break;
+
+          case ';':
+            if (!depth)
+            {
+              return n;
+            }
+
+            break;
+
+          case '*':
+            if (!depth && (is_keyword(s, p, "select") ||
+              is_keyword(s, p, "distinct") || is_keyword(s, p, "all") ||
+              is_punct(s, p, ',') || is_punct(s, p, '.')))
+            {
+              return unknown_count;
+            }
+
+            break;
+
+          default:
+            break;
+        }
+      }
+      else if (!depth && (is_keyword(s, t, "from") ||
+        is_keyword(s, t, "where") || is_keyword(s, t, "group") ||
+        is_keyword(s, t, "having") || is_keyword(s, t, "window") ||
+        is_keyword(s, t, "order") || is_keyword(s, t, "limit") ||
+        is_keyword(s, t, "union") || is_keyword(s, t, "intersect") ||
+        is_keyword(s, t, "except")))
+      {
+        break;
+      }
+    }
+
+    return n;
+  }
+  else if (is_keyword(s, t, "insert") || is_keyword(s, t, "replace") ||
+    is_keyword(s, t, "update") || is_keyword(s, t, "delete"))
+  {
+    for (; (TK_END != t.kind) && !is_punct(s, t, ';');
+      t = next_token(s, t.end))
+    {
+      if (is_keyword(s, t, "returning"))
+      {
+        return unknown_count;
+      }
+    }
+
+    return 0;
+  }
+  else
+  {
+    return unknown_count;
+  }
+}
+
+template <typename>
+struct signature_columns;
+
+template <typename R, typename ...A>
+struct signature_columns<signature<R(A...)>> :
+  std::integral_constant<std::size_t,
+    (std::size_t() + ... + count_types<remove_cvr_t<A>>{})
+  >
+{
+};
+
+template <typename ...A>
+struct signature_columns<signature<bool(std::size_t, A...)>> :
+  signature_columns<signature<bool(A...)>>
+{
+};
+
+}
+
+// sql text together with its parameter and column counts, as determined at
+// compile time, use the SQU_SQL() macro to make one
+template <std::size_t P, std::size_t C>
+struct sql
+{
+  static constexpr std::size_t params{P};
+  static constexpr std::size_t columns{C};
+
+  std::string_view const s_;
+
+  template <std::size_t N>
+  static constexpr void check_args() noexcept
+  {
+    static_assert((detail::unknown_count == P) || (N == P),
+      "argument count does not match the parameter count");
+  }
+
+  template <typename A, typename ...B>
+  auto exec(A&& a, B&& ...b) const noexcept(
+    noexcept(squ::exec(std::forward<A>(a), s_, std::forward<B>(b)...)))
+  {
+    check_args<sizeof...(B)>();
+
+    return squ::exec(std::forward<A>(a), s_, std::forward<B>(b)...);
+  }
+
+  template <typename T, typename A, typename ...B>
+  auto execget(A&& a, int const i = 0, B&& ...b) const noexcept(
+    noexcept(squ::execget<T>(std::forward<A>(a), s_, i,
+      std::forward<B>(b)...)))
+  {
+    check_args<sizeof...(B)>();
+    static_assert((detail::unknown_count == C) ||
+      (detail::count_types<T>{} <= C),
+      "result type has more columns than the statement");
+
+    return squ::execget<T>(std::forward<A>(a), s_, i,
+      std::forward<B>(b)...);
+  }
+
+  // prepare, bind b and call f for every row
+  template <typename A, typename F, typename ...B>
+  auto foreach_row(A&& a, F&& f, B&& ...b) const
+  {
+    check_args<sizeof...(B)>();
+    static_assert((detail::unknown_count == C) ||
+      (detail::signature_columns<
+        decltype(detail::extract_signature(f))>{} == C),
+      "row callback arity does not match the column count");
+
+    auto const s(squ::make_unique(std::forward<A>(a), s_));
+
+    if constexpr (bool(sizeof...(B)))
+    {
+      if (auto const r(squ::set(s, std::forward<B>(b)...)); SQLITE_OK != r)
+      {
+        return r;
+      }
+    }
+
+    return squ::foreach_row(s, std::forward<F>(f));
+  }
+
+  template <typename A>
+  auto shared(A&& a, unsigned fl = 0) const noexcept(
+    noexcept(squ::make_shared(std::forward<A>(a), s_, fl)))
+  {
+    return squ::make_shared(std::forward<A>(a), s_, fl);
+  }
+
+  template <typename A>
+  auto unique(A&& a, unsigned fl = 0) const noexcept(
+    noexcept(squ::make_unique(std::forward<A>(a), s_, fl)))
+  {
+    return squ::make_unique(std::forward<A>(a), s_, fl);
+  }
+};
+
+
+//typed_stmt//////////////////////////////////////////////////////////////////
+namespace detail
+{
+
+// the fundamental type a decoded C++ type expects, 0 if any will do
+template <typename T>
+constexpr int expected_type() noexcept
+{
+  if constexpr (std::is_integral_v<T>)
+  {
+    return SQLITE_INTEGER;
+  }
+  else if constexpr (std::is_floating_point_v<T>)
+  {
+    return SQLITE_FLOAT;
+  }
+  else if constexpr (std::is_same_v<T, char const*> ||
+    std::is_same_v<T, char16_t const*> ||
+    std::is_same_v<T, std::string> ||
+    std::is_same_v<T, std::string_view> ||
+    std::is_same_v<T, std::u16string> ||
+    std::is_same_v<T, std::u16string_view> ||
+    is_charpair<T>{} ||
+    is_char16pair<T>{} ||
+    is_interned<T>{})
+  {
+    return SQLITE_TEXT;
+  }
+  else if constexpr (std::is_same_v<T, void const*> ||
+    std::is_same_v<T, blobpair<STATIC>> ||
+    std::is_same_v<T, blobpair<TRANSIENT>> ||
+    is_const_span<T>{})
+  {
+    return SQLITE_BLOB;
+  }
+  else
+  {
+    return 0;
+  }
+}
+
+template <typename T>
+constexpr void column_types(int* const p) noexcept;
+
+template <typename T, std::size_t ...I>
+constexpr void column_types(int* const p, std::index_sequence<I...>) noexcept
+{
+  (
+    column_types<std::tuple_element_t<I, T>>(
+      p + count_types_n<I, 0, std::tuple_element_t<I, T>...>{}
+    ),
+    ...
+  );
+}
+
+template <typename T>
+constexpr void column_types(int* const p) noexcept
+{
+  if constexpr (is_std_pair<T>{} || is_std_tuple<T>{})
+  {
+    column_types<T>(p, std::make_index_sequence<std::tuple_size_v<T>>());
+  }
+  else
+  {
+    *p = expected_type<T>();
+  }
+}
+
+// expected fundamental types of the flattened columns of T
+template <typename T>
+constexpr auto column_types() noexcept
+{
+  std::array<int, count_types<T>{}> a{};
+
+  column_types<T>(a.data());
+
+  return a;
+}
+
+// the affinity sqlite derives from a declared column type, SQLITE_NULL
+// stands for NUMERIC and 0 for BLOB, no declared type or an expression
+inline int declared_affinity(char const* const d) noexcept
+{
+  if (!d)
+  {
+    return 0;
+  }
+
+  std::string_view const sv(d);
+
+  auto const has([sv](std::string_view const k) noexcept
+    {
+      return std::search(sv.begin(), sv.end(), k.begin(), k.end(),
+        [](char const a, char const b) noexcept
+        {
+          return ((a >= 'a') && (a <= 'z') ? char(a - 'a' + 'A') : a) == b;
+        }
+      ) != sv.end();
+    }
+  );
+
+  return has("INT") ? SQLITE_INTEGER :
+    has("CHAR") || has("CLOB") || has("TEXT") ? SQLITE_TEXT :
+    has("BLOB") || sv.empty() ? 0 :
+    has("REAL") || has("FLOA") || has("DOUB") ? SQLITE_FLOAT :
+    SQLITE_NULL;
+}
+
+// can a column of affinity a be decoded as e without conversions, columns
+// without affinity may hold anything and are accepted
+inline bool affinity_matches(int const e, int const a) noexcept
+{
+  switch (e)
+  {
+    case SQLITE_INTEGER:
+      return !a || (SQLITE_INTEGER == a) || (SQLITE_NULL == a);
+
+    case SQLITE_FLOAT:
+      return !a || (SQLITE_FLOAT == a) || (SQLITE_INTEGER == a) ||
+        (SQLITE_NULL == a);
+
+    case SQLITE_TEXT:
+      return !a || (SQLITE_TEXT == a);
+
+    case SQLITE_BLOB:
+      return !a;
+
+    default:
+      return true;
+  }
+}
+
+}
+
+// called by a debug typed_stmt for every cell whose stored type differs
+// from the type its row member expects
+using conversion_reporter_t = void (*)(sqlite3_stmt*, int column, int stored,
+  int expected) noexcept;
+
+// a statement whose result columns were checked against Row once, when it
+// was prepared, rows are then decoded without further checks, a Debug
+// statement additionally checks the stored type of every cell it decodes
+template <typename Row, bool Debug = false>
+class typed_stmt
+{
+  static constexpr auto types_{detail::column_types<Row>()};
+
+  unique_stmt_t s_;
+
+  int mismatch_{-1};
+
+  std::size_t conversions_{};
+  conversion_reporter_t reporter_{};
+
+  void check_schema() noexcept
+  {
+    auto const n(sqlite3_column_count(s_.get()));
+
+    for (int i{}, e(std::min(n, columns)); i != e; ++i)
+    {
+      if (!detail::affinity_matches(types_[i],
+        detail::declared_affinity(sqlite3_column_decltype(s_.get(), i))))
+      {
+        mismatch_ = i;
+
+        return;
+      }
+    }
+
+    if (n != columns)
+    {
+      mismatch_ = std::min(n, columns);
+    }
+  }
+
+  void check_cells() noexcept
+  {
+    for (int i{}; i != columns; ++i)
+    {
+      if (auto const t(sqlite3_column_type(s_.get(), i));
+        types_[i] && (SQLITE_NULL != t) && (types_[i] != t))
+      {
+        ++conversions_;
+
+        if (reporter_)
+        {
+          reporter_(s_.get(), i, t, types_[i]);
+        }
+      }
+    }
+  }
+
+public:
+  static constexpr int columns{int(detail::count_types<Row>{})};
+
+  typed_stmt() = default;
+
+  typed_stmt(sqlite3* const db, std::string_view const& sv,
+    unsigned const fl = 0) noexcept :
+    s_(make_unique(db, sv, fl))
+  {
+    if (s_)
+    {
+      check_schema();
+    }
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  typed_stmt(D const& db, std::string_view const& sv,
+    unsigned const fl = 0) noexcept :
+    typed_stmt(db.get(), sv, fl)
+  {
+  }
+
+  // prepared and every result column fits Row
+  explicit operator bool() const noexcept { return s_ && (-1 == mismatch_); }
+
+  auto get() const noexcept { return s_.get(); }
+
+  // index of the first column not fitting Row, or -1
+  auto mismatch() const noexcept { return mismatch_; }
+
+  auto conversions() const noexcept { return conversions_; }
+
+  void set_reporter(conversion_reporter_t const r) noexcept { reporter_ = r; }
+
+  template <int I = 1, typename ...A>
+  auto set(A&& ...args) noexcept
+  {
+    return squ::set<I>(s_.get(), std::forward<A>(args)...);
+  }
+
+  auto reset() noexcept { return sqlite3_reset(s_.get()); }
+
+  // step and decode the next row into r, returns the step result
+  auto next(Row& r) noexcept(noexcept(squ::get<Row>({})))
+  {
+    assert(*this);
+    auto const e(sqlite3_step(s_.get()));
+
+    if (SQLITE_ROW == e)
+    {
+      if constexpr (Debug)
+      {
+        check_cells();
+      }
+
+      r = squ::get<Row>(s_.get());
+    }
+
+    return e;
+  }
+
+  // call f with every remaining row, f may return true to stop early
+  template <typename F>
+  auto foreach_row(F&& f) noexcept(
+    noexcept(f(std::declval<Row>())) && noexcept(squ::get<Row>({})))
+  {
+    assert(*this);
+    int r;
+
+    for (;;)
+    {
+      switch (r = sqlite3_step(s_.get()))
+      {
+        case SQLITE_ROW:
+          if constexpr (Debug)
+          {
+            check_cells();
+          }
+
+          if constexpr (std::is_same_v<decltype(f(std::declval<Row>())),
+            bool>)
+          {
+            if (f(squ::get<Row>(s_.get())))
+            {
+              break;
+            }
+          }
+          else
+          {
+            f(squ::get<Row>(s_.get()));
+          }
+
+          continue;
+
+        case SQLITE_DONE:
+        case SQLITE_BUSY:
+        case SQLITE_LOCKED:
+        case SQLITE_INTERRUPT:
+          break;
+
+        default:
+          assert(!"unhandled result from exec");
+      }
+
+      break;
+    }
+
+    return r;
+  }
+};
+
+
+//prefetch_rows///////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_THREADS)
+namespace detail
+{
+
+// bump allocator for the text and blob columns of a row batch, chunks are
+// kept across clear()
+class row_arena
+{
+  static constexpr std::size_t chunk_size{1 << 16};
+
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  std::vector<std::unique_ptr<char[]>> large_;
+
+  std::size_t chunk_{};
+  std::size_t used_{};
+
+public:
+  // copies n bytes of p followed by z zero bytes, aligned to al, a power
+  // of two no greater than what new char[] guarantees
+  void* copy(void const* const p, std::size_t const n,
+    std::size_t const z = 0, std::size_t const al = alignof(char16_t))
+  {
+    auto const m(n + z);
+
+    char* q;
+
+    if (m > chunk_size)
+    {
+      q = large_.emplace_back(new char[m]).get();
+    }
+    else
+    {
+      if (used_ = (used_ + al - 1) & ~(al - 1);
+        chunks_.empty() || (used_ + m > chunk_size))
+      {
+        if (!chunks_.empty())
+        {
+          ++chunk_;
+        }
+
+        if (chunk_ == chunks_.size())
+        {
+          chunks_.emplace_back(new char[chunk_size]);
+        }
+
+        used_ = 0;
+      }
+
+      q = chunks_[chunk_].get() + used_;
+      used_ += m;
+    }
+
+    if (n)
+    {
+      std::memcpy(q, p, n);
+    }
+
+    std::memset(q + n, 0, z);
+
+    return q;
+  }
+
+  void clear() noexcept
+  {
+    large_.clear();
+
+    chunk_ = used_ = 0;
+  }
+};
+
+template <typename T, std::size_t ...I>
+inline T copy_tuple(sqlite3_stmt*, int, row_arena&, std::index_sequence<I...>);
+
+// get<T>(), but with text and blobs copied into a
+template <typename T>
+inline T copy_get(sqlite3_stmt* const s, int const i, row_arena& a)
+{
+  static_assert(!std::is_same_v<T, row_view>,
+    "a row_view reads the statement, which has moved on by the time the row "
+    "is used");
+
+  if constexpr (is_std_pair<T>{} || is_std_tuple<T>{})
+  {
+    return copy_tuple<T>(s, i, a,
+      std::make_index_sequence<std::tuple_size_v<T>>());
+  }
+  else if constexpr (std::is_same_v<T, char const*> ||
+    std::is_same_v<T, std::string_view> ||
+    is_charpair<T>{})
+  {
+    auto const p(sqlite3_column_text(s, i));
+    std::size_t const n(sqlite3_column_bytes(s, i));
+
+    auto const q(p ? static_cast<char const*>(a.copy(p, n, 1)) : nullptr);
+
+    if constexpr (std::is_same_v<T, char const*>)
+    {
+      return q;
+    }
+    else
+    {
+      return {q, n};
+    }
+  }
+  else if constexpr (std::is_same_v<T, char16_t const*> ||
+    std::is_same_v<T, std::u16string_view> ||
+    is_char16pair<T>{})
+  {
+    auto const p(sqlite3_column_text16(s, i));
+    std::size_t const n(sqlite3_column_bytes16(s, i));
+
+    auto const q(p ?
+      static_cast<char16_t const*>(a.copy(p, n, sizeof(char16_t))) :
+      nullptr);
+
+    if constexpr (std::is_same_v<T, char16_t const*>)
+    {
+      return q;
+    }
+    else
+    {
+      return {q, n / sizeof(char16_t)};
+    }
+  }
+  else if constexpr (is_const_span<T>{})
+  {
+    using E = typename T::element_type;
+
+    auto const p(sqlite3_column_blob(s, i));
+    std::size_t const n(sqlite3_column_bytes(s, i));
+
+    // copies are aligned, only the size can be wrong
+    assert(!p || !(n % sizeof(E)));
+
+    return !p || (n % sizeof(E)) ?
+      T() :
+      T(static_cast<E*>(a.copy(p, n, 0, alignof(E))), n / sizeof(E));
+  }
+  else if constexpr (std::is_same_v<T, void const*> ||
+    std::is_same_v<T, blobpair<STATIC>> ||
+    std::is_same_v<T, blobpair<TRANSIENT>>)
+  {
+    auto const p(sqlite3_column_blob(s, i));
+    std::size_t const n(sqlite3_column_bytes(s, i));
+
+    auto const q(p ? a.copy(p, n) : nullptr);
+
+    if constexpr (std::is_same_v<T, void const*>)
+    {
+      return q;
+    }
+    else
+    {
+      return {q, n};
+    }
+  }
+  else
+  {
+    return get<T>(s, i);
+  }
+}
+
+template <typename T, std::size_t ...I>
+inline T copy_tuple(sqlite3_stmt* const s, int const i, row_arena& a,
+  std::index_sequence<I...>)
+{
+  return T{
+    copy_get<std::tuple_element_t<I, T>>(s,
+      i + count_types_n<I, 0, std::tuple_element_t<I, T>...>{}, a
+    )...
+  };
+}
+
+// a batch of decoded rows, owning the text and blobs the rows point to
+template <typename ...A>
+struct row_batch
+{
+  using row_t = std::tuple<A...>;
+
+  std::vector<row_t> rows;
+  row_arena arena;
+
+  void clear() noexcept
+  {
+    rows.clear();
+    arena.clear();
+  }
+
+  // step s until n rows have been decoded or it stops returning rows,
+  // returns the result of the last step
+  int fill(sqlite3_stmt* const s, std::size_t const n)
+  {
+    rows.reserve(n);
+
+    return fill(s, n, std::make_index_sequence<sizeof...(A)>());
+  }
+
+private:
+  template <std::size_t ...I>
+  int fill(sqlite3_stmt* const s, std::size_t const n,
+    std::index_sequence<I...>)
+  {
+    while (rows.size() != n)
+    {
+      if (auto const r(sqlite3_step(s)); SQLITE_ROW == r)
+      {
+        rows.emplace_back(
+          copy_get<A>(s, count_types_n<I, 0, A...>{}, arena)...
+        );
+      }
+      else
+      {
+        return r;
+      }
+    }
+
+    return SQLITE_ROW;
+  }
+};
+
+}
+
+// steps a statement on a background thread, decoding batches of rows ahead
+// of the consumer iterating it, the statement's connection must not be used
+// by anyone else until the prefetcher is destroyed
+template <typename ...A>
+class row_prefetcher
+{
+  using batch_t = std::unique_ptr<detail::row_batch<A...>>;
+
+  detail::bounded_queue<batch_t> full_;
+  detail::bounded_queue<batch_t> empty_;
+
+  batch_t b_;
+  std::size_t i_{};
+
+  int r_{SQLITE_DONE};
+
+  std::thread t_;
+
+  bool next()
+  {
+    if (b_ && (++i_ != b_->rows.size()))
+    {
+      return true;
+    }
+    else
+    {
+      if (b_)
+      {
+        empty_.push(std::move(b_));
+      }
+
+      i_ = 0;
+
+      if (!full_.pop(b_))
+      {
+        b_.reset();
+
+        return false;
+      }
+
+      return true;
+    }
+  }
+
+public:
+  using row_t = std::tuple<A...>;
+
+  class iterator
+  {
+    row_prefetcher* p_;
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = row_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = row_t const*;
+    using reference = row_t const&;
+
+    explicit iterator(row_prefetcher* const p = {}) noexcept : p_(p) { }
+
+    reference operator*() const noexcept { return p_->b_->rows[p_->i_]; }
+
+    pointer operator->() const noexcept { return &**this; }
+
+    iterator& operator++()
+    {
+      if (!p_->next())
+      {
+        p_ = {};
+      }
+
+      return *this;
+    }
+
+    bool operator==(iterator const& o) const noexcept { return p_ == o.p_; }
+
+    bool operator!=(iterator const& o) const noexcept { return p_ != o.p_; }
+  };
+
+  row_prefetcher(sqlite3_stmt* const s, std::size_t const depth,
+    std::size_t const rows) :
+    full_(depth),
+    empty_(depth + 1)
+  {
+    for (auto i(depth + 1); i; --i)
+    {
+      empty_.push(std::make_unique<detail::row_batch<A...>>());
+    }
+
+    t_ = std::thread([this, s, n(std::max(rows, std::size_t(1)))]()
+      {
+        for (batch_t b; empty_.pop(b);)
+        {
+          b->clear();
+
+          auto const r(b->fill(s, n));
+
+          if (SQLITE_ROW != r)
+          {
+            r_ = r;
+          }
+
+          if ((!b->rows.empty() && !full_.push(std::move(b))) ||
+            (SQLITE_ROW != r))
+          {
+            break;
+          }
+        }
+
+        full_.close();
+      }
+    );
+  }
+
+  row_prefetcher(row_prefetcher const&) = delete;
+
+  ~row_prefetcher()
+  {
+    full_.close();
+    empty_.close();
+
+    t_.join();
+  }
+
+  row_prefetcher& operator=(row_prefetcher const&) = delete;
+
+  iterator begin()
+  {
+    return b_ || next() ? iterator(this) : iterator();
+  }
+
+  iterator end() noexcept { return iterator(); }
+
+  // result of the last step, valid once iteration has ended
+  auto result() const noexcept { return r_; }
+};
+
+// iterate the rows of s as std::tuple<A...>, with up to depth batches of
+// rows decoded ahead by a background thread
+template <typename ...A>
+inline auto prefetch_rows(sqlite3_stmt* const s, std::size_t const depth = 2,
+  std::size_t const rows = 256)
+{
+  return row_prefetcher<A...>(s, depth, rows);
+}
+
+// forwarders
+template <typename ...A, typename S,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto prefetch_rows(S const& s, std::size_t const depth = 2,
+  std::size_t const rows = 256)
+{
+  return row_prefetcher<A...>(s.get(), depth, rows);
+}
+#endif // SQU_ENABLE_THREADS
+
+
+//parallel_foreach_row////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_THREADS)
+namespace detail
+{
+
+struct no_results
+{
+};
+
+// a batch of rows together with what the callback returned for each of them,
+// bools are kept in a deque, as std::vector<bool> hands out proxies
+template <typename R, typename ...A>
+struct parallel_chunk
+{
+  row_batch<A...> batch;
+
+  std::conditional_t<std::is_void_v<R>, no_results,
+    std::conditional_t<std::is_same_v<R, bool>, std::deque<bool>,
+    std::vector<R>>> results;
+
+  std::size_t seq;
+};
+
+// per worker deques of chunks, a worker takes from the back of its own and
+// steals from the front of the others'
+template <typename C>
+class steal_pool
+{
+  struct deque
+  {
+    std::mutex m;
+    std::list<C*> q;
+  };
+
+  std::vector<deque> d_;
+
+  // chunks pushed and not yet taken, counted before they are queued, so
+  // that it never drops below zero
+  std::size_t queued_{};
+  bool stop_{};
+
+  std::mutex m_;
+  std::condition_variable cv_;
+
+  C* take(std::size_t const w) noexcept
+  {
+    for (std::size_t i{}, n(d_.size()); i != n; ++i)
+    {
+      auto& d(d_[(w + i) % n]);
+
+      C* c{};
+
+      {
+        std::lock_guard<std::mutex> l(d.m);
+
+        if (!d.q.empty())
+        {
+          if (i)
+          {
+            c = d.q.front();
+            d.q.pop_front();
+          }
+          else
+          {
+            c = d.q.back();
+            d.q.pop_back();
+          }
+        }
+      }
+
+      if (c)
+      {
+        std::lock_guard<std::mutex> l(m_);
+        --queued_;
+
+        return c;
+      }
+    }
+
+    return nullptr;
+  }
+
+public:
+  explicit steal_pool(std::size_t const n) : d_(n)
+  {
+  }
+
+  void push(std::size_t const w, C* const c)
+  {
+    {
+      std::lock_guard<std::mutex> l(m_);
+      ++queued_;
+    }
+
+    {
+      auto& d(d_[w % d_.size()]);
+
+      std::lock_guard<std::mutex> l(d.m);
+      d.q.push_back(c);
+    }
+
+    cv_.notify_one();
+  }
+
+  // next chunk for worker w, nullptr once stopped
+  C* pop(std::size_t const w)
+  {
+    for (;;)
+    {
+      if (auto const c(take(w)); c)
+      {
+        return c;
+      }
+
+      std::unique_lock<std::mutex> l(m_);
+
+      cv_.wait(l, [&]() noexcept { return stop_ || queued_; });
+
+      if (stop_ && !queued_)
+      {
+        return nullptr;
+      }
+    }
+  }
+
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> l(m_);
+      stop_ = true;
+    }
+
+    cv_.notify_all();
+  }
+};
+
+// the calling thread steps s and decodes chunks of rows, which threads
+// workers pass to f, finished chunks are handed to done in order
+template <typename R, typename ...A, typename F, typename D>
+inline int parallel_rows(sqlite3_stmt* const s, F const& f, unsigned threads,
+  std::size_t rows, D&& done)
+{
+  static_assert((!std::is_same_v<A, row_view> && ...),
+    "workers cannot read the statement the calling thread is stepping");
+
+  using chunk_t = parallel_chunk<R, A...>;
+
+  threads = std::max(threads, 1u);
+  rows = std::max(rows, std::size_t(1));
+
+  std::vector<std::unique_ptr<chunk_t>> chunks(2 * threads);
+  std::vector<chunk_t*> free;
+
+  for (auto& c: chunks)
+  {
+    free.push_back((c = std::make_unique<chunk_t>()).get());
+  }
+
+  steal_pool<chunk_t> pool(threads);
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<chunk_t*> finished;
+
+  std::vector<std::thread> workers;
+
+  for (unsigned w{}; w != threads; ++w)
+  {
+    workers.emplace_back([&, w]()
+      {
+        while (auto const c = pool.pop(w))
+        {
+          for (auto& row: c->batch.rows)
+          {
+            if constexpr (std::is_void_v<R>)
+            {
+              std::apply(f, row);
+            }
+            else
+            {
+              c->results.push_back(std::apply(f, row));
+            }
+          }
+
+          {
+            std::lock_guard<std::mutex> l(m);
+            finished.push_back(c);
+          }
+
+          cv.notify_one();
+        }
+      }
+    );
+  }
+
+  std::size_t next{}, retired{};
+
+  std::vector<chunk_t*> ready;
+
+  // hand finished chunks to done in sequence, outside the lock the workers
+  // need, and recycle them
+  auto const retire([&](bool const wait)
+    {
+      {
+        std::unique_lock<std::mutex> l(m);
+
+        if (wait)
+        {
+          cv.wait(l, [&]() noexcept
+            {
+              return std::any_of(finished.cbegin(), finished.cend(),
+                [&](auto const c) noexcept { return retired == c->seq; });
+            }
+          );
+        }
+
+        for (auto i(finished.begin()); i != finished.end();)
+        {
+          if (retired == (*i)->seq)
+          {
+            ready.push_back(*i);
+
+            finished.erase(i);
+            i = finished.begin();
+
+            ++retired;
+          }
+          else
+          {
+            ++i;
+          }
+        }
+      }
+
+      for (auto const c: ready)
+      {
+        done(*c);
+        free.push_back(c);
+      }
+
+      ready.clear();
+    }
+  );
+
+  int r;
+
+  for (;;)
+  {
+    while (free.empty())
+    {
+      retire(true);
+    }
+
+    auto const c(free.back());
+    free.pop_back();
+
+    c->batch.clear();
+
+    if constexpr (!std::is_void_v<R>)
+    {
+      c->results.clear();
+    }
+
+    r = c->batch.fill(s, rows);
+
+    if (c->batch.rows.empty())
+    {
+      free.push_back(c);
+    }
+    else
+    {
+      c->seq = next;
+      pool.push(next++, c);
+    }
+
+    if (SQLITE_ROW != r)
+    {
+      break;
+    }
+  }
+
+  while (retired != next)
+  {
+    retire(true);
+  }
+
+  pool.stop();
+
+  for (auto& t: workers)
+  {
+    t.join();
+  }
+
+  return r;
+}
+
+template <typename ...A, typename F>
+inline auto parallel_foreach_row(sqlite3_stmt* const s, F const& f,
+  unsigned const threads, std::size_t const rows, signature<void(A...)>)
+{
+  return parallel_rows<void, remove_cvr_t<A>...>(s, f, threads, rows,
+    [](auto&) noexcept {});
+}
+
+template <typename R, typename ...A, typename F, typename T, typename O>
+inline auto parallel_reduce_rows(sqlite3_stmt* const s, F const& f,
+  unsigned const threads, std::size_t const rows, T&& init, O const& op,
+  signature<R(A...)>)
+{
+  std::pair<int, remove_cvr_t<T>> r{{}, std::forward<T>(init)};
+
+  r.first = parallel_rows<R, remove_cvr_t<A>...>(s, f, threads, rows,
+    [&](auto& c)
+    {
+      for (auto& v: c.results)
+      {
+        r.second = op(std::move(r.second), std::move(v));
+      }
+    }
+  );
+
+  return r;
+}
+
+}
+
+// call f for every row of s on a pool of threads, rows are decoded into
+// chunks on the calling thread, f must be safe to call concurrently and
+// should not throw, text arguments stay valid only for the duration of a
+// call, returns the result of the last step
+template <typename F>
+inline auto parallel_foreach_row(sqlite3_stmt* const s, F const& f,
+  unsigned const threads = std::thread::hardware_concurrency(),
+  std::size_t const rows = 256)
+{
+  return detail::parallel_foreach_row(s, f, threads, rows,
+    detail::extract_signature(f));
+}
+
+// as parallel_foreach_row(), but folds what f returns for each row into
+// init with op, in row order, on the calling thread, returns the result of
+// the last step and the reduced value
+template <typename F, typename T, typename O>
+inline auto parallel_foreach_row(sqlite3_stmt* const s, F const& f,
+  unsigned const threads, T&& init, O const& op,
+  std::size_t const rows = 256)
+{
+  return detail::parallel_reduce_rows(s, f, threads, rows,
+    std::forward<T>(init), op, detail::extract_signature(f));
+}
+
+// forwarders
+template <typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto parallel_foreach_row(S const& s, A&& ...args)
+{
+  return parallel_foreach_row(s.get(), std::forward<A>(args)...);
+}
+#endif // SQU_ENABLE_THREADS
+
+
+//script//////////////////////////////////////////////////////////////////////
+struct script_result
+{
+  int result;
+
+  // index of the statement that failed, size() if none did
+  std::size_t index;
+};
+
+// a multi-statement script split into its statements once, which can then
+// be run again and again without being parsed anew, statements are
+// prepared as they are first run, so that they may use the schema created
+// by those before them
+class script
+{
+  sqlite3* db_{};
+
+  std::string sql_;
+
+  // offset of the text not yet prepared
+  std::size_t tail_{};
+
+  unsigned fl_{};
+
+  std::vector<unique_stmt_t> s_;
+
+  script_result r_{SQLITE_OK, 0};
+
+public:
+  script() = default;
+
+  script(sqlite3* const db, std::string_view const& sv,
+    unsigned const fl = SQLITE_PREPARE_PERSISTENT) :
+    db_(db),
+    sql_(sv),
+    fl_(fl)
+  {
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  script(D const& db, std::string_view const& sv,
+    unsigned const fl = SQLITE_PREPARE_PERSISTENT) :
+    script(db.get(), sv, fl)
+  {
+  }
+
+  // the last prepare succeeded
+  explicit operator bool() const noexcept { return SQLITE_OK == r_.result; }
+
+  // result of the last prepare, with the index of the statement it was for
+  auto const& prepared() const noexcept { return r_; }
+
+  // all statements are prepared
+  bool complete() const noexcept { return sql_.size() == tail_; }
+
+  // statements prepared so far
+  auto size() const noexcept { return s_.size(); }
+
+  sqlite3_stmt* operator[](std::size_t const i) const noexcept
+  {
+    return s_[i].get();
+  }
+
+  // prepare the next statement, a failed prepare, e.g. of a statement using
+  // a table not yet created, is retried by the next call, returns
+  // SQLITE_DONE once the text is used up
+  int prepare_next() noexcept
+  {
+    while (!complete())
+    {
+      sqlite3_stmt* s;
+      char const* tail;
+
+      if (auto const r(sqlite3_prepare_v3(db_, sql_.data() + tail_,
+        sql_.size() - tail_, fl_, &s, &tail)); SQLITE_OK != r)
+      {
+        r_ = {r, s_.size()};
+
+        return r;
+      }
+      else
+      {
+        tail_ = std::size_t(tail - sql_.data());
+
+        // whitespace or a comment yield no statement
+        if (s)
+        {
+          s_.emplace_back(s);
+
+          r_ = {SQLITE_OK, s_.size()};
+
+          return SQLITE_OK;
+        }
+      }
+    }
+
+    r_ = {SQLITE_OK, s_.size()};
+
+    return SQLITE_DONE;
+  }
+
+  // prepare all remaining statements up front, for scripts that do not
+  // change the schema they use
+  script_result prepare() noexcept
+  {
+    for (int r; SQLITE_DONE != (r = prepare_next());)
+    {
+      if (SQLITE_OK != r)
+      {
+        return r_;
+      }
+    }
+
+    return r_;
+  }
+
+  // run the statements in order, f(i, s) is called before statement i is
+  // run and may bind its parameters, returning anything but SQLITE_OK to
+  // stop, rows the statements return are discarded
+  template <typename F>
+  script_result exec(F&& f) noexcept(
+    noexcept(f(std::size_t(), std::declval<sqlite3_stmt*>())))
+  {
+    for (std::size_t i{};; ++i)
+    {
+      if ((i == s_.size()) && (SQLITE_OK != prepare_next()))
+      {
+        if (SQLITE_OK != r_.result)
+        {
+          return r_;
+        }
+
+        break;
+      }
+
+      auto const s(s_[i].get());
+
+      if (auto const r(f(i, s)); SQLITE_OK != r)
+      {
+        return {r, i};
+      }
+
+      int r;
+
+      while (SQLITE_ROW == (r = sqlite3_step(s)));
+
+      // release whatever the statement holds before running the next one
+      sqlite3_reset(s);
+
+      if (SQLITE_DONE != r)
+      {
+        return {r, i};
+      }
+    }
+
+    return {SQLITE_DONE, s_.size()};
+  }
+
+  script_result exec() noexcept
+  {
+    return exec([](std::size_t, sqlite3_stmt*) noexcept { return SQLITE_OK; });
+  }
+};
+
+
+//cursor//////////////////////////////////////////////////////////////////////
+// keyset pagination over a statement of the form
+// "SELECT ... WHERE key > ?1 ORDER BY key LIMIT ?2", the key of the last row
+// of a page, read from column k, is bound for the next one and the
+// statement is reset after every page, so no transaction stays open between
+// pages, K must own its value
+template <typename K>
+class cursor
+{
+  static_assert(!std::is_same_v<K, std::string_view> &&
+    !std::is_same_v<K, char const*>, "key type must own its value");
+
+  unique_stmt_t s_;
+
+  K last_;
+  int k_;
+
+  bool done_{};
+
+public:
+  cursor(sqlite3* const db, std::string_view const& sv, K first,
+    int const k = 0) noexcept :
+    s_(make_unique(db, sv, SQLITE_PREPARE_PERSISTENT)),
+    last_(std::move(first)),
+    k_(k)
+  {
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  cursor(D const& db, std::string_view const& sv, K first,
+    int const k = 0) noexcept :
+    cursor(db.get(), sv, std::move(first), k)
+  {
+  }
+
+  explicit operator bool() const noexcept { return bool(s_); }
+
+  // a page shorter than requested was returned
+  auto done() const noexcept { return done_; }
+
+  auto const& last() const noexcept { return last_; }
+
+  // continue after key k
+  void seek(K k) noexcept(std::is_nothrow_move_assignable_v<K>)
+  {
+    last_ = std::move(k);
+    done_ = false;
+  }
+
+  // append up to n rows, decoded from column i on, to c
+  template <typename C>
+  auto page(C& c, std::size_t const n, int const i = 0)
+  {
+    assert(s_);
+    auto const s(s_.get());
+
+    if (auto const r(set(s, last_, sqlite3_int64(n))); SQLITE_OK != r)
+    {
+      return r;
+    }
+
+    int r;
+    std::size_t j{};
+
+    for (;;)
+    {
+      switch (r = sqlite3_step(s))
+      {
+        case SQLITE_ROW:
+          c.emplace_back(get<typename C::value_type>(s, i));
+          last_ = get<K>(s, k_);
+          ++j;
+
+          continue;
+
+        case SQLITE_DONE:
+          done_ = j < n;
+
+          break;
+
+        case SQLITE_BUSY:
+        case SQLITE_LOCKED:
+        case SQLITE_INTERRUPT:
+          break;
+
+        default:
+          assert(!"unhandled result from exec");
+      }
+
+      break;
+    }
+
+    sqlite3_reset(s);
+
+    return r;
+  }
+};
+
+
+//utf16///////////////////////////////////////////////////////////////////////
+namespace detail
+{
+
+// the number of trailing zero bits of k, which must not be 0
+inline unsigned ctz(unsigned const k) noexcept
+{
+  assert(k);
+
+#if defined(_MSC_VER)
+  unsigned long r;
+  _BitScanForward(&r, k);
+
+  return unsigned(r);
+#else
+  return unsigned(__builtin_ctz(k));
+#endif // _MSC_VER
+}
+
+// transcode n bytes of UTF-8 at p into at most m units at q, returns
+// SQLITE_OK, SQLITE_MISMATCH for malformed input or SQLITE_TOOBIG if q is
+// too small, together with the number of units written
+inline std::pair<int, std::size_t> utf8_to_utf16(char const* const p,
+  std::size_t const n, char16_t* const q, std::size_t const m) noexcept
+{
+  std::size_t i{}, o{};
+
+  while (i != n)
+  {
+    // runs of ASCII are widened a vector at a time
+#if defined(__AVX2__) && !defined(SQU_NO_SIMD)
+    for (; (n - i >= 32) && (m - o >= 32); i += 32, o += 32)
+    {
+      auto const v(_mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(p + i)));
+
+      if (_mm256_movemask_epi8(v))
+      {
+        break;
+      }
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(q + o),
+        _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(q + o + 16),
+        _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+    }
+#endif // __AVX2__ && !SQU_NO_SIMD
+
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(SQU_NO_SIMD)
+    for (; (n - i >= 16) && (m - o >= 16); i += 16, o += 16)
+    {
+      auto const v(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i)));
+      auto const z(_mm_setzero_si128());
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(q + o),
+        _mm_unpacklo_epi8(v, z));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(q + o + 8),
+        _mm_unpackhi_epi8(v, z));
+
+      // keep the ASCII prefix, the units past it are written over later
+      if (auto const k(_mm_movemask_epi8(v)); k)
+      {
+        std::size_t const a(ctz(unsigned(k)));
+
+        i += a;
+        o += a;
+
+        break;
+      }
+    }
+#endif // (__SSE2__ || _M_X64) && !SQU_NO_SIMD
+
+    if (i == n)
+    {
+      break;
+    }
+
+    std::uint32_t c(static_cast<unsigned char>(p[i]));
+
+    if (c < 0x80)
+    {
+      if (o == m)
+      {
+        return {SQLITE_TOOBIG, o};
+      }
+
+      q[o++] = char16_t(c);
+      ++i;
+
+      continue;
+    }
+
+    std::size_t l;
+    std::uint32_t min;
+
+    if ((c >= 0xc2) && (c <= 0xdf))
+    {
+      l = 2;
+      min = 0x80;
+      c &= 0x1f;
+    }
+    else if ((c >= 0xe0) && (c <= 0xef))
+    {
+      l = 3;
+      min = 0x800;
+      c &= 0x0f;
+    }
+    else if ((c >= 0xf0) && (c <= 0xf4))
+    {
+      l = 4;
+      min = 0x10000;
+      c &= 0x07;
+    }
+    else
+    {
+      return {SQLITE_MISMATCH, o};
+    }
+
+    if (n - i < l)
+    {
+      return {SQLITE_MISMATCH, o};
+    }
+
+    for (std::size_t j(1); j != l; ++j)
+    {
+      if (std::uint32_t const b(static_cast<unsigned char>(p[i + j]));
+        0x80 == (b & 0xc0))
+      {
+        c = (c << 6) | (b & 0x3f);
+      }
+      else
+      {
+        return {SQLITE_MISMATCH, o};
+      }
+    }
+
+    // overlong forms, surrogates and what lies beyond unicode
+    if ((c < min) || ((c >= 0xd800) && (c <= 0xdfff)) || (c > 0x10ffff))
+    {
+      return {SQLITE_MISMATCH, o};
+    }
+
+    if (c < 0x10000)
+    {
+      if (o == m)
+      {
+        return {SQLITE_TOOBIG, o};
+      }
+
+      q[o++] = char16_t(c);
+    }
+    else
+    {
+      if (m - o < 2)
+      {
+        return {SQLITE_TOOBIG, o};
+      }
+
+      c -= 0x10000;
+
+      q[o++] = char16_t(0xd800 | (c >> 10));
+      q[o++] = char16_t(0xdc00 | (c & 0x3ff));
+    }
+
+    i += l;
+  }
+
+  return {SQLITE_OK, o};
+}
+
+// transcode n units of UTF-16 at p into at most m bytes at q, results as
+// for utf8_to_utf16()
+inline std::pair<int, std::size_t> utf16_to_utf8(char16_t const* const p,
+  std::size_t const n, char* const q, std::size_t const m) noexcept
+{
+  std::size_t i{}, o{};
+
+  while (i != n)
+  {
+    // runs of ASCII are narrowed a vector at a time
+#if defined(__AVX2__) && !defined(SQU_NO_SIMD)
+    for (; (n - i >= 32) && (m - o >= 32); i += 32, o += 32)
+    {
+      auto const a(_mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(p + i)));
+      auto const b(_mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(p + i + 16)));
+
+      if (!_mm256_testz_si256(_mm256_or_si256(a, b),
+        _mm256_set1_epi16(short(0xff80))))
+      {
+        break;
+      }
+
+      // packus works within 128-bit lanes
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(q + o),
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+    }
+#endif // __AVX2__ && !SQU_NO_SIMD
+
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(SQU_NO_SIMD)
+    for (; (n - i >= 16) && (m - o >= 16); i += 16, o += 16)
+    {
+      auto const a(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i)));
+      auto const b(_mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(p + i + 8)));
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(q + o),
+        _mm_packus_epi16(a, b));
+
+      // a bit per unit that is not ASCII, the ASCII prefix is kept and the
+      // bytes past it are written over later
+      auto const m8(_mm_set1_epi16(short(0xff80)));
+      auto const z(_mm_setzero_si128());
+
+      if (auto const k(~_mm_movemask_epi8(_mm_packs_epi16(
+        _mm_cmpeq_epi16(_mm_and_si128(a, m8), z),
+        _mm_cmpeq_epi16(_mm_and_si128(b, m8), z))) & 0xffff); k)
+      {
+        std::size_t const c(ctz(unsigned(k)));
+
+        i += c;
+        o += c;
+
+        break;
+      }
+    }
+#endif // (__SSE2__ || _M_X64) && !SQU_NO_SIMD
+
+    if (i == n)
+    {
+      break;
+    }
+
+    std::uint32_t c(p[i++]);
+
+    if ((c >= 0xd800) && (c <= 0xdbff))
+    {
+      if ((i == n) || (p[i] < 0xdc00) || (p[i] > 0xdfff))
+      {
+        return {SQLITE_MISMATCH, o};
+      }
+
+      c = 0x10000 + ((c - 0xd800) << 10) + (p[i++] - 0xdc00);
+    }
+    else if ((c >= 0xdc00) && (c <= 0xdfff))
+    {
+      return {SQLITE_MISMATCH, o};
+    }
+
+    auto const l(c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4);
+
+    if (m - o < std::size_t(l))
+    {
+      return {SQLITE_TOOBIG, o};
+    }
+
+    switch (l)
+    {
+      case 1:
+        q[o++] = char(c);
+        break;
+
+      case 2:
+        q[o++] = char(0xc0 | (c >> 6));
+        q[o++] = char(0x80 | (c & 0x3f));
+        break;
+
+      case 3:
+        q[o++] = char(0xe0 | (c >> 12));
+        q[o++] = char(0x80 | ((c >> 6) & 0x3f));
+        q[o++] = char(0x80 | (c & 0x3f));
+        break;
+
+      default:
+        q[o++] = char(0xf0 | (c >> 18));
+        q[o++] = char(0x80 | ((c >> 12) & 0x3f));
+        q[o++] = char(0x80 | ((c >> 6) & 0x3f));
+        q[o++] = char(0x80 | (c & 0x3f));
+    }
+  }
+
+  return {SQLITE_OK, o};
+}
+
+}
+
+// decode column i as UTF-16 into the m units at q, transcoding the UTF-8
+// text sqlite stores rather than having it convert and cache a copy, m
+// units always suffice for column_bytes(s, i), returns SQLITE_OK,
+// SQLITE_MISMATCH or SQLITE_TOOBIG and the number of units written
+inline auto get_utf16(sqlite3_stmt* const s, int const i, char16_t* const q,
+  std::size_t const m) noexcept
+{
+  auto const p(reinterpret_cast<char const*>(sqlite3_column_text(s, i)));
+
+  return p ?
+    detail::utf8_to_utf16(p, sqlite3_column_bytes(s, i), q, m) :
+    std::pair<int, std::size_t>(SQLITE_OK, 0);
+}
+
+// transcode v to UTF-8 into the m bytes at q and bind those to parameter
+// I, q must stay valid while bound, 3 * v.size() bytes always suffice
+template <int I = 1>
+inline int set_utf16(sqlite3_stmt* const s, std::u16string_view const& v,
+  char* const q, std::size_t const m) noexcept
+{
+  auto const r(detail::utf16_to_utf8(v.data(), v.size(), q, m));
+
+  return SQLITE_OK == r.first ?
+    sqlite3_bind_text64(s, I, q, r.second, SQLITE_STATIC, SQLITE_UTF8) :
+    r.first;
+}
+
+// forwarders
+template <typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto get_utf16(S const& s, A&& ...args) noexcept(
+  noexcept(get_utf16(s.get(), std::forward<A>(args)...)))
+{
+  return get_utf16(s.get(), std::forward<A>(args)...);
+}
+
+template <int I = 1, typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto set_utf16(S const& s, A&& ...args) noexcept(
+  noexcept(set_utf16<I>(s.get(), std::forward<A>(args)...)))
+{
+  return set_utf16<I>(s.get(), std::forward<A>(args)...);
+}
+
+
+//batch_inserter//////////////////////////////////////////////////////////////
+// buffers rows of A... and inserts them K at a time with multi-row
+// "INSERT ... VALUES (?, ...), ..." statements, K is lowered to what
+// SQLITE_LIMIT_VARIABLE_NUMBER allows, a remainder is inserted with the
+// statements for smaller powers of two, all of which are prepared once
+template <std::size_t K, typename ...A>
+class batch_inserter
+{
+  static_assert(K && !(K & (K - 1)), "batch size must be a power of two");
+  static_assert(sizeof...(A), "rows must have columns");
+
+  using row_t = std::tuple<A...>;
+
+  static constexpr std::size_t log2(std::size_t const n) noexcept
+  {
+    return n > 1 ? 1 + log2(n >> 1) : 0;
+  }
+
+  sqlite3* const db_;
+  std::string const head_;
+
+  std::array<unique_stmt_t, log2(K) + 1> s_;
+
+  std::vector<row_t> rows_;
+  std::size_t k_{K};
+
+  template <int I>
+  static int bind_row(sqlite3_stmt* const s, row_t const& r) noexcept
+  {
+    if constexpr (1 == sizeof...(A))
+    {
+      return detail::set<I>(s, std::get<0>(r));
+    }
+    else
+    {
+      return std::apply([s](auto const& ...a) noexcept
+        {
+          return detail::set<I>(s,
+            std::make_index_sequence<sizeof...(A) - 1>(), a...);
+        },
+        r
+      );
+    }
+  }
+
+  template <std::size_t ...J>
+  static int bind(sqlite3_stmt* const s, row_t const* const p,
+    std::index_sequence<J...>) noexcept
+  {
+    int r(SQLITE_OK);
+
+    (
+      (
+        SQLITE_OK == r ?
+          r = bind_row<int(1 + J * sizeof...(A))>(s, p[J]) :
+          r
+      ),
+      ...
+    );
+
+    return r;
+  }
+
+  // insert as many n rows at p as possible 2^J at a time, then continue
+  // with 2^(J - 1)
+  template <std::size_t J>
+  int run(row_t const*& p, std::size_t& n)
+  {
+    constexpr std::size_t N(std::size_t(1) << J);
+
+    if (N <= k_)
+    {
+      for (; n >= N; p += N, n -= N)
+      {
+        auto& s(s_[J]);
+
+        if (!s)
+        {
+          // not make_unique(), a bad head is reported rather than asserted
+          auto const q(sql(N));
+          sqlite3_stmt* t;
+
+          if (auto const r(sqlite3_prepare_v3(db_, q.data(), q.size(),
+            SQLITE_PREPARE_PERSISTENT, &t, nullptr)); SQLITE_OK != r)
+          {
+            return r;
+          }
+
+          s.reset(t);
+        }
+
+        auto r(bind(s.get(), p, std::make_index_sequence<N>()));
+
+        if (SQLITE_OK == r)
+        {
+          r = sqlite3_step(s.get());
+          sqlite3_reset(s.get());
+        }
+
+        if (SQLITE_DONE != r)
+        {
+          return r;
+        }
+      }
+    }
+
+    if constexpr (bool(J))
+    {
+      return run<J - 1>(p, n);
+    }
+    else
+    {
+      return SQLITE_OK;
+    }
+  }
+
+  std::string sql(std::size_t const n) const
+  {
+    std::string r(head_);
+
+    r.append(" VALUES");
+
+    for (std::size_t i{}; i != n; ++i)
+    {
+      r.append(i ? ",(" : "(");
+
+      for (std::size_t j{}; j != sizeof...(A); ++j)
+      {
+        r.append(j ? ",?" : "?");
+      }
+
+      r.push_back(')');
+    }
+
+    return r;
+  }
+
+public:
+  // head is the statement up to VALUES, e.g. "INSERT INTO t(a, b)"
+  batch_inserter(sqlite3* const db, std::string_view const& head) :
+    db_(db),
+    head_(head)
+  {
+    for (std::size_t const l(sqlite3_limit(db, SQLITE_LIMIT_VARIABLE_NUMBER,
+      -1)); (k_ > 1) && (k_ * sizeof...(A) > l); k_ /= 2);
+
+    rows_.reserve(k_);
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  batch_inserter(D const& db, std::string_view const& head) :
+    batch_inserter(db.get(), head)
+  {
+  }
+
+  // rows still buffered are inserted, errors are ignored, call flush()
+  // before to learn the outcome
+  ~batch_inserter()
+  {
+    try
+    {
+      flush();
+    }
+    catch (...)
+    {
+    }
+  }
+
+  // rows per statement, after applying the variable limit
+  auto batch_size() const noexcept { return k_; }
+
+  // buffer a row, inserting the buffer once it holds a full batch, the
+  // row must not refer to memory that goes away before then
+  template <typename ...B>
+  int insert(B&& ...b)
+  {
+    rows_.emplace_back(std::forward<B>(b)...);
+
+    return rows_.size() >= k_ ? flush() : SQLITE_OK;
+  }
+
+  // insert all buffered rows, rows that were not inserted stay buffered, so
+  // that the flush can be retried, or the rows dropped with clear()
+  int flush()
+  {
+    row_t const* p(rows_.data());
+    auto n(rows_.size());
+
+    auto const r(run<log2(K)>(p, n));
+
+    rows_.erase(rows_.begin(), rows_.begin() + (p - rows_.data()));
+
+    return r;
+  }
+
+  // rows buffered and not yet inserted
+  auto size() const noexcept { return rows_.size(); }
+
+  void clear() noexcept { rows_.clear(); }
+};
+
+
+//stmt_registry///////////////////////////////////////////////////////////////
+// a statement of a registry that failed to prepare on a connection, or whose
+// plan has problems
+struct warmup_problem
+{
+  std::size_t connection;
+  std::size_t id;
+
+  // result of preparing, SQLITE_OK if only the plan is at fault
+  int result;
+
+  // plan_problem flags
+  int plan;
+};
+
+// a registry's statements as prepared on one connection, indexed by id,
+// statements that failed to prepare are null
+using prepared_stmts = std::vector<unique_stmt_t>;
+
+// sql a service declares up front, so that every connection can prepare all
+// of it before serving its first request
+class stmt_registry
+{
+  std::vector<std::string> sql_;
+
+public:
+  // returns the id of the statement
+  std::size_t add(std::string_view const& sql)
+  {
+    sql_.emplace_back(sql);
+
+    return sql_.size() - 1;
+  }
+
+  auto size() const noexcept { return sql_.size(); }
+
+  auto const& sql(std::size_t const id) const noexcept { return sql_[id]; }
+
+  // prepare every statement persistently on db, appending problems to p
+  prepared_stmts prepare(sqlite3* const db, std::vector<warmup_problem>& p,
+    std::size_t const c = 0) const
+  {
+    prepared_stmts r(sql_.size());
+
+    for (std::size_t id{}; id != sql_.size(); ++id)
+    {
+      sqlite3_stmt* s;
+
+      // not make_unique(), failures are reported rather than asserted
+      if (auto const e(sqlite3_prepare_v3(db, sql_[id].data(),
+        sql_[id].size(), SQLITE_PREPARE_PERSISTENT, &s, nullptr));
+        SQLITE_OK != e)
+      {
+        p.push_back({c, id, e, 0});
+      }
+      else if (r[id].reset(s); s)
+      {
+        if (auto const q(detail::plan_problems(s)); q)
+        {
+          p.push_back({c, id, SQLITE_OK, q});
+        }
+      }
+    }
+
+    return r;
+  }
+
+#if defined(SQU_ENABLE_THREADS)
+  // prepare every statement on every connection of [b, e), one thread per
+  // connection, problems are ordered by connection
+  template <typename It>
+  std::pair<std::vector<prepared_stmts>, std::vector<warmup_problem>>
+  warm(It b, It const e) const
+  {
+    std::size_t const n(std::distance(b, e));
+
+    std::vector<prepared_stmts> r(n);
+    std::vector<std::vector<warmup_problem>> p(n);
+
+    {
+      std::vector<std::thread> t;
+      t.reserve(n);
+
+      for (std::size_t c{}; b != e; ++b, ++c)
+      {
+        sqlite3* db;
+
+        if constexpr (is_db_v<decltype(*b)>)
+        {
+          db = b->get();
+        }
+        else
+        {
+          db = *b;
+        }
+
+        t.emplace_back([&, db, c]()
+          {
+            r[c] = prepare(db, p[c], c);
+          }
+        );
+      }
+
+      for (auto& th: t)
+      {
+        th.join();
+      }
+    }
+
+    std::vector<warmup_problem> q;
+
+    for (auto& v: p)
+    {
+      q.insert(q.end(), v.cbegin(), v.cend());
+    }
+
+    return {std::move(r), std::move(q)};
+  }
+
+  template <typename C>
+  auto warm(C const& c) const
+  {
+    return warm(std::begin(c), std::end(c));
+  }
+#endif // SQU_ENABLE_THREADS
+};
+
+
+//recorder////////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_RECORDER)
+// a log starts with the magic, then holds records, each a tag byte and
+// varints:
+//   STRING: length, bytes, the string gets the next id, from 0
+//   EVENT: connection, start in us relative to that of the previous event
+//     (zigzag), duration in ns, string id, number of parameters, and for
+//     each its index and a value
+// a value is a value tag and INTEGER: zigzag varint, FLOAT: 8 bytes,
+// TEXT, BLOB: length, bytes, ZEROBLOB: length, NULL: nothing
+namespace detail
+{
+
+inline constexpr char record_magic[8]{'S', 'Q', 'U', 'R', 'E', 'C', '2', '\0'};
+
+enum record_tag : unsigned char
+{
+  RECORD_STRING,
+  RECORD_EVENT
+};
+
+enum record_value : unsigned char
+{
+  RECORD_INTEGER = SQLITE_INTEGER,
+  RECORD_FLOAT = SQLITE_FLOAT,
+  RECORD_TEXT = SQLITE_TEXT,
+  RECORD_BLOB = SQLITE_BLOB,
+  RECORD_NULL = SQLITE_NULL,
+  RECORD_ZEROBLOB
+};
+
+inline void put_varint(std::string& s, std::uint64_t v)
+{
+  for (; v >= 0x80; v >>= 7)
+  {
+    s.push_back(char(v | 0x80));
+  }
+
+  s.push_back(char(v));
+}
+
+inline bool get_varint(char const*& p, char const* const e,
+  std::uint64_t& v) noexcept
+{
+  v = 0;
+
+  for (unsigned sh{}; (p != e) && (sh < 64); sh += 7)
+  {
+    auto const c(static_cast<unsigned char>(*p++));
+
+    v |= std::uint64_t(c & 0x7f) << sh;
+
+    if (!(c & 0x80))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+constexpr std::uint64_t zigzag(std::int64_t const v) noexcept
+{
+  return (std::uint64_t(v) << 1) ^ std::uint64_t(v >> 63);
+}
+
+constexpr std::int64_t unzigzag(std::uint64_t const v) noexcept
+{
+  return std::int64_t(v >> 1) ^ -std::int64_t(v & 1);
+}
+
+// end of the parameter token at p, p if there is none, as sqlite's
+// tokenizer sees them: ?NNN, :AAA, @AAA, $AAA and #AAA
+inline char const* parameter_end(char const* p) noexcept
+{
+  auto const id([](char const c) noexcept
+    {
+      return ((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) ||
+        ((c >= 'A') && (c <= 'Z')) || ('_' == c) || ('$' == c) ||
+        (static_cast<unsigned char>(c) >= 0x80);
+    }
+  );
+
+  switch (*p)
+  {
+    case '?':
+      while ((*++p >= '0') && (*p <= '9'));
+
+      return p;
+
+    case ':':
+    case '@':
+    case '$':
+    case '#':
+    {
+      auto const b(p);
+
+      // tcl namespaces are separated by ::
+      for (++p; id(*p) || ((':' == *p) && (':' == p[1]));
+        p += ':' == *p ? 2 : 1);
+
+      return p - b > 1 ? p : b;
+    }
+
+    default:
+      return p;
+  }
+}
+
+// append the literal sqlite3_expanded_sql() wrote at x as a value, returns
+// the end of the literal, nullptr if there is none
+inline char const* record_literal(std::string& o, char const* x)
+{
+  if (!std::strncmp(x, "NULL", 4))
+  {
+    o.push_back(char(RECORD_NULL));
+
+    return x + 4;
+  }
+  else if ('\'' == *x)
+  {
+    std::string v;
+
+    for (++x; *x; ++x)
+    {
+      if ('\'' == *x)
+      {
+        if ('\'' == x[1])
+        {
+          ++x;
+        }
+        else
+        {
+          o.push_back(char(RECORD_TEXT));
+          put_varint(o, v.size());
+          o.append(v);
+
+          return x + 1;
+        }
+      }
+
+      v.push_back(*x);
+    }
+
+    return nullptr;
+  }
+  else if (('x' == *x) && ('\'' == x[1]))
+  {
+    std::string v;
+
+    for (x += 2;; x += 2)
+    {
+      unsigned char c;
+
+      if (auto const [p, ec](std::from_chars(x, x + 2, c, 16));
+        (std::errc() != ec) || (x + 2 != p))
+      {
+        break;
+      }
+
+      v.push_back(char(c));
+    }
+
+    if ('\'' != *x)
+    {
+      return nullptr;
+    }
+
+    o.push_back(char(RECORD_BLOB));
+    put_varint(o, v.size());
+    o.append(v);
+
+    return x + 1;
+  }
+  else if (!std::strncmp(x, "zeroblob(", 9))
+  {
+    std::uint64_t n;
+    auto const [p, ec](std::from_chars(x + 9, x + std::strlen(x), n));
+
+    if ((std::errc() != ec) || (')' != *p))
+    {
+      return nullptr;
+    }
+
+    o.push_back(char(RECORD_ZEROBLOB));
+    put_varint(o, n);
+
+    return p + 1;
+  }
+  else
+  {
+    auto const e(x + std::strlen(x));
+
+    std::int64_t i;
+
+    if (auto const [p, ec](std::from_chars(x, e, i)); (std::errc() == ec) &&
+      ('.' != *p) && ('e' != *p) && ('E' != *p))
+    {
+      o.push_back(char(RECORD_INTEGER));
+      put_varint(o, zigzag(i));
+
+      return p;
+    }
+
+    // sqlite writes infinities as 9.0e+999 or Inf
+    double d;
+
+    auto [p, ec](std::from_chars(x, e, d));
+
+    if (std::errc::result_out_of_range == ec)
+    {
+      d = '-' == *x ? -HUGE_VAL : HUGE_VAL;
+    }
+    else if (std::errc() != ec)
+    {
+      if (!std::strncmp(x, "Inf", 3) || !std::strncmp(x, "-Inf", 4))
+      {
+        d = '-' == *x ? -HUGE_VAL : HUGE_VAL;
+        p = x + ('-' == *x ? 4 : 3);
+      }
+      else
+      {
+        return nullptr;
+      }
+    }
+
+    o.push_back(char(RECORD_FLOAT));
+    o.append(reinterpret_cast<char const*>(&d), sizeof(d));
+
+    return p;
+  }
+}
+
+// recover the values bound to s by walking its sql, t, and expanded sql, x,
+// side by side, which differ only where a parameter was replaced by its
+// value, appends the number of parameters and the parameters
+inline void record_parameters(std::string& o, sqlite3_stmt* const s,
+  char const* t, char const* x)
+{
+  auto const m(sqlite3_bind_parameter_count(s));
+
+  std::string v;
+  std::uint64_t n{};
+
+  std::vector<bool> seen(m + 1);
+
+  for (int last{}; x;)
+  {
+    for (; *t && (*t == *x); ++t, ++x);
+
+    // statements run from within others come back commented out
+    auto const te(parameter_end(t));
+
+    if (te == t)
+    {
+      break;
+    }
+
+    int i;
+
+    if ('?' == *t)
+    {
+      if (i = last + 1; te - t > 1)
+      {
+        std::from_chars(t + 1, te, i);
+      }
+    }
+    else
+    {
+      i = sqlite3_bind_parameter_index(s, std::string(t, te).c_str());
+    }
+
+    auto const l(v.size());
+
+    if ((i > 0) && (i <= m) && !seen[i])
+    {
+      seen[i] = true;
+      put_varint(v, unsigned(i));
+
+      if ((x = record_literal(v, x)))
+      {
+        ++n;
+      }
+      else
+      {
+        v.resize(l);
+      }
+    }
+    else
+    {
+      std::string d;
+      x = record_literal(d, x);
+    }
+
+    last = std::max(last, i);
+    t = te;
+  }
+
+  put_varint(o, n);
+  o.append(v);
+}
+
+// bind the n parameters recorded at p, which stay in place while bound, to
+// s, or only check them if s is nullptr
+inline bool bind_recorded(sqlite3_stmt* const s, char const*& p,
+  char const* const e, std::uint64_t n) noexcept
+{
+  for (; n; --n)
+  {
+    std::uint64_t i, l;
+
+    if (!get_varint(p, e, i) || (p == e))
+    {
+      return false;
+    }
+
+    int r;
+
+    switch (auto const tag(*p++); tag)
+    {
+      case RECORD_INTEGER:
+        if (!get_varint(p, e, l))
+        {
+          return false;
+        }
+
+        r = s ? sqlite3_bind_int64(s, int(i), unzigzag(l)) : SQLITE_OK;
+
+        break;
+
+      case RECORD_FLOAT:
+      {
+        double d;
+
+        if (std::size_t(e - p) < sizeof(d))
+        {
+          return false;
+        }
+
+        std::memcpy(&d, p, sizeof(d));
+        p += sizeof(d);
+
+        r = s ? sqlite3_bind_double(s, int(i), d) : SQLITE_OK;
+
+        break;
+      }
+
+      case RECORD_TEXT:
+      case RECORD_BLOB:
+        if (!get_varint(p, e, l) || (std::uint64_t(e - p) < l))
+        {
+          return false;
+        }
+
+        r = !s ? SQLITE_OK : RECORD_TEXT == tag ?
+          sqlite3_bind_text64(s, int(i), p, l, SQLITE_STATIC, SQLITE_UTF8) :
+          sqlite3_bind_blob64(s, int(i), p, l, SQLITE_STATIC);
+
+        p += l;
+
+        break;
+
+      case RECORD_ZEROBLOB:
+        if (!get_varint(p, e, l))
+        {
+          return false;
+        }
+
+        r = s ? sqlite3_bind_zeroblob64(s, int(i), l) : SQLITE_OK;
+
+        break;
+
+      case RECORD_NULL:
+        r = s ? sqlite3_bind_null(s, int(i)) : SQLITE_OK;
+
+        break;
+
+      default:
+        return false;
+    }
+
+    if (SQLITE_OK != r)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}
+
+// logs the statements run on attached connections to a file, each with its
+// connection, its start and duration and the values bound to it, which are
+// recovered from the expanded sql, so floating point values keep 15 digits,
+// identical statement texts are stored once
+class recorder
+{
+  std::unique_ptr<std::FILE, int (*)(std::FILE*)> f_;
+
+  std::mutex m_;
+
+  std::string buf_;
+  std::unordered_map<std::string, std::uint64_t> ids_;
+
+  std::unordered_map<sqlite3*, std::uint64_t> connections_;
+
+  std::chrono::steady_clock::time_point const start_{
+    std::chrono::steady_clock::now()};
+
+  std::int64_t last_{};
+
+  static void profile(void* const p, sqlite3_stmt* const s,
+    sqlite3_int64 const ns) noexcept
+  {
+    static_cast<recorder*>(p)->record(s, ns);
+  }
+
+  void record(sqlite3_stmt* const s, sqlite3_int64 const ns) noexcept
+  {
+    auto const now(std::chrono::steady_clock::now());
+
+    auto const sql(sqlite3_sql(s));
+
+    if (!sql)
+    {
+      return;
+    }
+
+    try
+    {
+      std::string p;
+
+      if (sqlite3_bind_parameter_count(s))
+      {
+        std::unique_ptr<char, void (*)(void*)> const x(
+          sqlite3_expanded_sql(s), &sqlite3_free);
+
+        detail::record_parameters(p, s, sql, x.get());
+      }
+      else
+      {
+        p.push_back('\0');
+      }
+
+      // the statement started ns before it was profiled
+      auto const t(std::chrono::duration_cast<std::chrono::microseconds>(
+        now - start_).count() - ns / 1000);
+
+      std::string e;
+
+      std::lock_guard<std::mutex> l(m_);
+
+      auto const c(connections_.find(sqlite3_db_handle(s)));
+
+      if (connections_.end() == c)
+      {
+        return;
+      }
+
+      auto const i(ids_.try_emplace(sql, ids_.size()));
+
+      if (i.second)
+      {
+        e.push_back(char(detail::RECORD_STRING));
+        detail::put_varint(e, i.first->first.size());
+        e.append(i.first->first);
+      }
+
+      e.push_back(char(detail::RECORD_EVENT));
+      detail::put_varint(e, c->second);
+      detail::put_varint(e, detail::zigzag(t - last_));
+      detail::put_varint(e, ns);
+      detail::put_varint(e, i.first->second);
+      e.append(p);
+
+      // a record is appended whole or not at all
+      buf_.append(e);
+
+      last_ = t;
+
+      if (buf_.size() >= (1 << 16))
+      {
+        write();
+      }
+    }
+    catch (...)
+    {
+      // running out of memory costs us the record, not the statement
+    }
+  }
+
+  void write() noexcept
+  {
+    if (f_)
+    {
+      std::fwrite(buf_.data(), 1, buf_.size(), f_.get());
+    }
+
+    buf_.clear();
+  }
+
+public:
+  explicit recorder(char const* const path) :
+    f_(std::fopen(path, "wb"), &std::fclose)
+  {
+    buf_.append(detail::record_magic, sizeof(detail::record_magic));
+  }
+
+  recorder(recorder const&) = delete;
+
+  ~recorder()
+  {
+    flush();
+  }
+
+  recorder& operator=(recorder const&) = delete;
+
+  explicit operator bool() const noexcept { return bool(f_); }
+
+  // record the statements db runs, each attach starts a new connection of
+  // the log; the trace callback of db is shared with the other components
+  // of this library, but not with one of the application
+  int attach(sqlite3* const db)
+  {
+    {
+      std::lock_guard<std::mutex> l(m_);
+
+      connections_[db] = connections_.size();
+    }
+
+    detail::hooks::subscribe(db, {this, this, {}, {}, &recorder::profile});
+
+    return SQLITE_OK;
+  }
+
+  int detach(sqlite3* const db) noexcept
+  {
+    detail::hooks::unsubscribe(db, this);
+
+    std::lock_guard<std::mutex> l(m_);
+
+    connections_.erase(db);
+
+    return SQLITE_OK;
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  auto attach(D const& db)
+  {
+    return attach(db.get());
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  auto detach(D const& db) noexcept
+  {
+    return detach(db.get());
+  }
+
+  void flush() noexcept
+  {
+    std::lock_guard<std::mutex> l(m_);
+
+    write();
+
+    if (f_)
+    {
+      std::fflush(f_.get());
+    }
+  }
+};
+#endif // SQU_ENABLE_RECORDER
+
+//replay//////////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_RECORDER)
+struct replay_options
+{
+  // start statements when the log says they started, relative to the first
+  bool paced{};
+
+  // with paced, how much faster than recorded to replay
+  double speed{1};
+
+  int flags{SQLITE_OPEN_READWRITE};
+
+  // replaying connections contend for the database like recorded ones did
+  std::chrono::milliseconds busy_timeout{5000};
+
+  // replay every recorded connection this many times at once, each copy on
+  // a connection of its own, to multiply the load on the database, copies
+  // of writes that must be unique then fail
+  unsigned copies{1};
+};
+
+struct replay_result
+{
+  // SQLITE_OK, or why the log or database could not be opened
+  int result;
+
+  // copies times the recorded connections, each on its own thread
+  std::size_t connections;
+
+  std::uint64_t statements;
+  std::uint64_t failures;
+
+  std::chrono::nanoseconds elapsed;
+
+  // of the steps and reset of every statement, in ns, sorted
+  std::vector<std::uint64_t> latencies;
+};
+
+// run the statements of the log at path against the database at db, which
+// should be a copy of the recorded one, the statements of every recorded
+// connection in order on a connection of their own
+inline replay_result replay(char const* const path, char const* const db,
+  replay_options const& o = {})
+{
+  replay_result r{SQLITE_OK, 0, 0, 0, {}, {}};
+
+  std::string log;
+
+  {
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> const f(
+      std::fopen(path, "rb"), &std::fclose);
+
+    if (!f)
+    {
+      r.result = SQLITE_CANTOPEN;
+
+      return r;
+    }
+
+    char buf[1 << 16];
+
+    for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), f.get()));)
+    {
+      log.append(buf, n);
+    }
+  }
+
+  if (log.compare(0, sizeof(detail::record_magic),
+    detail::record_magic, sizeof(detail::record_magic)))
+  {
+    r.result = SQLITE_NOTADB;
+
+    return r;
+  }
+
+  struct event
+  {
+    // us since the first event
+    std::int64_t start;
+
+    std::uint64_t id;
+
+    // the recorded parameters
+    char const* params;
+    std::uint64_t n;
+  };
+
+  std::vector<std::string_view> strings;
+
+  std::unordered_map<std::uint64_t, std::size_t> index;
+  std::vector<std::vector<event>> connections;
+
+  {
+    std::int64_t t{};
+
+    for (char const* p(log.data() + sizeof(detail::record_magic)),
+      * const e(log.data() + log.size()); p != e;)
+    {
+      std::uint64_t a, b, c, d, n;
+
+      switch (*p++)
+      {
+        case detail::RECORD_STRING:
+          if (detail::get_varint(p, e, a) && (std::uint64_t(e - p) >= a))
+          {
+            strings.emplace_back(p, a);
+            p += a;
+
+            continue;
+          }
+
+          break;
+
+        case detail::RECORD_EVENT:
+          if (detail::get_varint(p, e, a) && detail::get_varint(p, e, b) &&
+            detail::get_varint(p, e, c) && detail::get_varint(p, e, d) &&
+            (d < strings.size()) && detail::get_varint(p, e, n))
+          {
+            t += detail::unzigzag(b);
+
+            auto const [i, inserted](index.try_emplace(a,
+              connections.size()));
+
+            if (inserted)
+            {
+              connections.emplace_back();
+            }
+
+            auto& v(connections[i->second]);
+
+            v.push_back({t, d, p, n});
+
+            // check the parameters, with a statement that takes none
+            if (detail::bind_recorded(nullptr, p, e, n))
+            {
+              continue;
+            }
+          }
+
+          break;
+
+        default:;
+      }
+
+      r.result = SQLITE_CORRUPT;
+
+      return r;
+    }
+  }
+
+  auto first(std::numeric_limits<std::int64_t>::max());
+
+  for (auto& v: connections)
+  {
+    first = std::min(first, v.front().start);
+  }
+
+  auto const threads(connections.size() * o.copies);
+
+  r.connections = threads;
+
+  std::vector<std::vector<std::uint64_t>> lat(threads);
+  std::vector<std::uint64_t> failures(threads);
+  std::vector<int> results(threads, SQLITE_OK);
+
+  auto const start(std::chrono::steady_clock::now());
+
+  {
+    std::vector<std::thread> t;
+
+    for (std::size_t w{}; w != threads; ++w)
+    {
+      t.emplace_back([&, w]()
+        {
+          sqlite3* c;
+
+          if (auto const e(sqlite3_open_v2(db, &c, o.flags, nullptr));
+            SQLITE_OK != e)
+          {
+            sqlite3_close(c);
+            results[w] = e;
+
+            return;
+          }
+
+          unique_db_t const h(c);
+
+          sqlite3_busy_timeout(c, int(o.busy_timeout.count()));
+
+          std::unordered_map<std::uint64_t, unique_stmt_t> cache;
+
+          for (auto& ev: connections[w % connections.size()])
+          {
+            if (o.paced)
+            {
+              std::this_thread::sleep_until(start +
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::duration<double, std::micro>(
+                    (ev.start - first) / o.speed)));
+            }
+
+            auto& s(cache[ev.id]);
+
+            if (!s)
+            {
+              auto const& q(strings[ev.id]);
+              sqlite3_stmt* p;
+
+              if (SQLITE_OK != sqlite3_prepare_v3(c, q.data(), q.size(),
+                SQLITE_PREPARE_PERSISTENT, &p, nullptr))
+              {
+                ++failures[w];
+
+                continue;
+              }
+
+              s.reset(p);
+            }
+
+            if (auto p(ev.params);
+              !detail::bind_recorded(s.get(), p, log.data() + log.size(),
+                ev.n))
+            {
+              ++failures[w];
+
+              sqlite3_clear_bindings(s.get());
+
+              continue;
+            }
+
+            // what the recorded statement paid, not preparing and binding
+            auto const b(std::chrono::steady_clock::now());
+
+            int e;
+
+            while (SQLITE_ROW == (e = sqlite3_step(s.get())));
+
+            sqlite3_reset(s.get());
+
+            lat[w].push_back(std::chrono::duration_cast<
+              std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - b).count());
+
+            sqlite3_clear_bindings(s.get());
+
+            failures[w] += SQLITE_DONE != e;
+          }
+        }
+      );
+    }
+
+    for (auto& th: t)
+    {
+      th.join();
+    }
+  }
+
+  r.elapsed = std::chrono::steady_clock::now() - start;
+
+  for (std::size_t w{}; w != threads; ++w)
+  {
+    if (SQLITE_OK != results[w])
+    {
+      r.result = results[w];
+    }
+
+    r.failures += failures[w];
+    r.latencies.insert(r.latencies.end(), lat[w].cbegin(), lat[w].cend());
+  }
+
+  r.statements = r.latencies.size();
+
+  std::sort(r.latencies.begin(), r.latencies.end());
+
+  return r;
+}
+#endif // SQU_ENABLE_RECORDER
+
+
+//interrupt///////////////////////////////////////////////////////////////////
+inline void interrupt(sqlite3* const db) noexcept
+{
+  sqlite3_interrupt(db);
+}
+
+template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+inline void interrupt(D const& db) noexcept
+{
+  interrupt(db.get());
+}
+
+//deadline_guard//////////////////////////////////////////////////////////////
+// lets another thread cancel what a deadline_guard watches
+class cancel_token
+{
+  std::atomic<bool> c_{};
+
+public:
+  void cancel() noexcept { c_.store(true, std::memory_order_relaxed); }
+
+  bool cancelled() const noexcept
+  {
+    return c_.load(std::memory_order_relaxed);
+  }
+
+  void reset() noexcept { c_.store(false, std::memory_order_relaxed); }
+};
+
+// what a call interrupted by a deadline_guard whose deadline passed returns,
+// its primary code, r & 0xff, is still SQLITE_INTERRUPT
+inline constexpr int INTERRUPT_DEADLINE{SQLITE_INTERRUPT | (1 << 8)};
+
+// while in scope, statements run on db stop with SQLITE_INTERRUPT once the
+// deadline passes or the token is cancelled, which is checked every ops
+// virtual machine instructions from the progress handler, no handler is
+// installed if there is neither a deadline nor a token
+//
+// guards nest on a thread, an inner one also stops at the deadlines of the
+// outer ones and puts back their handler when it goes, but sqlite cannot
+// report any other progress handler, which is replaced and then cleared
+class deadline_guard
+{
+  sqlite3* const db_;
+
+  std::chrono::steady_clock::time_point const deadline_;
+  cancel_token const* const t_;
+
+  int const ops_;
+
+  // the enclosing guard of db_, and the one below on the stack of guards of
+  // this thread, which may be of another connection
+  deadline_guard const* prev_{};
+  deadline_guard const* below_{};
+
+  mutable bool expired_{};
+
+  static deadline_guard const*& top() noexcept
+  {
+    thread_local deadline_guard const* top;
+
+    return top;
+  }
+
+  bool installed() const noexcept
+  {
+    return (std::chrono::steady_clock::time_point::max() != deadline_) || t_;
+  }
+
+  static int handler(void* const p) noexcept
+  {
+    for (auto g(static_cast<deadline_guard const*>(p)); g; g = g->prev_)
+    {
+      if (g->t_ && g->t_->cancelled())
+      {
+        return 1;
+      }
+      else if ((std::chrono::steady_clock::time_point::max() != g->deadline_)
+        && (g->expired_ = g->deadline_ <= std::chrono::steady_clock::now()))
+      {
+        return 1;
+      }
+    }
+
+    return 0;
+  }
+
+  deadline_guard const* outer() const noexcept
+  {
+    for (auto g(top()); g; g = g->below_)
+    {
+      if (db_ == g->db_)
+      {
+        return g;
+      }
+    }
+
+    return nullptr;
+  }
+
+public:
+  deadline_guard(sqlite3* const db,
+    std::chrono::steady_clock::time_point const d,
+    cancel_token const* const t = {}, int const ops = 1000) noexcept :
+    db_(db),
+    deadline_(d),
+    t_(t),
+    ops_(ops)
+  {
+    if (installed())
+    {
+      prev_ = outer();
+      below_ = top();
+      top() = this;
+
+      sqlite3_progress_handler(db, ops, handler, this);
+    }
+  }
+
+  deadline_guard(sqlite3* const db,
+    std::chrono::steady_clock::duration const d,
+    cancel_token const* const t = {}, int const ops = 1000) noexcept :
+    deadline_guard(db, std::chrono::steady_clock::now() + d, t, ops)
+  {
+  }
+
+  // cancellation only
+  deadline_guard(sqlite3* const db, cancel_token const& t,
+    int const ops = 1000) noexcept :
+    deadline_guard(db, std::chrono::steady_clock::time_point::max(), &t, ops)
+  {
+  }
+
+  template <typename D, typename ...A,
+    typename = std::enable_if_t<is_db_v<D>>
+  >
+  deadline_guard(D const& db, A&& ...args) noexcept :
+    deadline_guard(db.get(), std::forward<A>(args)...)
+  {
+  }
+
+  deadline_guard(deadline_guard const&) = delete;
+
+  ~deadline_guard()
+  {
+    if (installed())
+    {
+      assert(this == top());
+      top() = below_;
+
+      prev_ ?
+        sqlite3_progress_handler(db_, prev_->ops_, handler,
+          const_cast<deadline_guard*>(prev_)) :
+        sqlite3_progress_handler(db_, 0, nullptr, nullptr);
+    }
+  }
+
+  deadline_guard& operator=(deadline_guard const&) = delete;
+
+  // a statement was interrupted because a deadline passed, rather than
+  // because a token was cancelled
+  auto expired() const noexcept
+  {
+    for (auto g(this); g; g = g->prev_)
+    {
+      if (g->expired_)
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // r, with SQLITE_INTERRUPT turned into INTERRUPT_DEADLINE if a deadline
+  // passed
+  int result(int const r) const noexcept
+  {
+    return (SQLITE_INTERRUPT == r) && expired() ? INTERRUPT_DEADLINE : r;
+  }
+};
+
+// call f() with a deadline on db, e.g.
+//
+//   with_deadline(db, 50ms, [&]{ return foreach_row(s, f); });
+//
+// returns what f returns, INTERRUPT_DEADLINE for SQLITE_INTERRUPT if the
+// deadline passed
+template <typename F, typename D>
+inline auto with_deadline(sqlite3* const db, D const d, F&& f,
+  int const ops = 1000) noexcept(noexcept(f()))
+{
+  deadline_guard const g(db, d, nullptr, ops);
+
+  if constexpr (std::is_same_v<decltype(f()), int>)
+  {
+    return g.result(f());
+  }
+  else
+  {
+    return f();
+  }
+}
+
+template <typename F, typename D, typename E,
+  typename = std::enable_if_t<is_db_v<E>>
+>
+inline auto with_deadline(E const& db, D const d, F&& f,
+  int const ops = 1000) noexcept(noexcept(f()))
+{
+  return with_deadline(db.get(), d, std::forward<F>(f), ops);
+}
+
+
+//coroutines//////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_COROUTINES) && defined(__cpp_impl_coroutine) && \
+  defined(__cpp_lib_coroutine)
+// an executor E is anything callable as e(std::coroutine_handle<>) that
+// resumes the handle later, on the thread owning the connection, e.g. by
+// posting it to an event loop
+class offloader;
+
+namespace detail
+{
+
+template <typename T>
+struct task_result
+{
+  std::optional<T> v;
+
+  template <typename U>
+  void return_value(U&& u) { v.emplace(std::forward<U>(u)); }
+};
+
+template <>
+struct task_result<void>
+{
+  void return_void() noexcept { }
+};
+
+template <typename E>
+struct reschedule_awaiter
+{
+  E& e;
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> const h) { e(h); }
+
+  void await_resume() const noexcept { }
+};
+
+struct offload_job
+{
+  void (*run)(offload_job&);
+  void (*resume)(offload_job&);
+};
+
+template <typename E, typename F>
+struct offload_awaiter : offload_job
+{
+  using result_t = std::invoke_result_t<F&>;
+
+  offloader& o;
+  E& e;
+  F f;
+
+  std::conditional_t<std::is_void_v<result_t>, no_results,
+    std::optional<result_t>> r;
+
+  std::coroutine_handle<> h;
+
+  offload_awaiter(offloader& o, E& e, F&& f) :
+    offload_job{[](offload_job& j)
+      {
+        auto& a(static_cast<offload_awaiter&>(j));
+
+        if constexpr (std::is_void_v<result_t>)
+        {
+          a.f();
+        }
+        else
+        {
+          a.r.emplace(a.f());
+        }
+      },
+      [](offload_job& j)
+      {
+        auto& a(static_cast<offload_awaiter&>(j));
+
+        a.e(a.h);
+      }
+    },
+    o(o),
+    e(e),
+    f(std::move(f))
+  {
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> const c);
+
+  result_t await_resume()
+  {
+    if constexpr (!std::is_void_v<result_t>)
+    {
+      return std::move(*r);
+    }
+  }
+};
+
+// call f with the current row of s, true if f wants to stop
+template <typename F, typename R, typename ...A, std::size_t ...I>
+inline bool call_row(sqlite3_stmt* const s, F& f, signature<R(A...)>,
+  std::index_sequence<I...>)
+{
+  if constexpr (std::is_same_v<R, bool>)
+  {
+    return f(get<remove_cvr_t<A>>(s, int(count_types_n<I, 0, A...>{}))...);
+  }
+  else
+  {
+    f(get<remove_cvr_t<A>>(s, int(count_types_n<I, 0, A...>{}))...);
+
+    return false;
+  }
+}
+
+template <typename F, typename R, typename ...A>
+inline bool call_row(sqlite3_stmt* const s, F& f, signature<R(A...)> const g)
+{
+  return call_row(s, f, g, std::make_index_sequence<sizeof...(A)>());
+}
+
+}
+
+// a lazily started coroutine, it runs when awaited or started
+template <typename T = void>
+class task
+{
+public:
+  struct promise_type : detail::task_result<T>
+  {
+    std::coroutine_handle<> c_;
+
+    task get_return_object() noexcept
+    {
+      return task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    auto final_suspend() const noexcept
+    {
+      struct awaiter
+      {
+        bool await_ready() const noexcept { return false; }
+
+        // continue with whoever awaited the task
+        std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> const h) const noexcept
+        {
+          auto const c(h.promise().c_);
+
+          return c ? c : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept { }
+      };
+
+      return awaiter{};
+    }
+
+    // exceptions are not part of this library
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+
+private:
+  std::coroutine_handle<promise_type> h_;
+
+  explicit task(std::coroutine_handle<promise_type> const h) noexcept :
+    h_(h)
+  {
+  }
+
+public:
+  task(task&& o) noexcept : h_(std::exchange(o.h_, {})) { }
+
+  task(task const&) = delete;
+
+  ~task()
+  {
+    if (h_)
+    {
+      h_.destroy();
+    }
+  }
+
+  task& operator=(task const&) = delete;
+
+  // run a task nobody awaits until its first suspension
+  void start() const { h_.resume(); }
+
+  bool done() const noexcept { return h_.done(); }
+
+  // of a done task
+  decltype(auto) result() const noexcept
+  {
+    if constexpr (!std::is_void_v<T>)
+    {
+      return *h_.promise().v;
+    }
+  }
+
+  auto operator co_await() noexcept
+  {
+    struct awaiter
+    {
+      std::coroutine_handle<promise_type> h;
+
+      bool await_ready() const noexcept { return false; }
+
+      auto await_suspend(std::coroutine_handle<> const c) const noexcept
+      {
+        h.promise().c_ = c;
+
+        return h;
+      }
+
+      T await_resume() const
+      {
+        if constexpr (!std::is_void_v<T>)
+        {
+          return std::move(*h.promise().v);
+        }
+      }
+    };
+
+    return awaiter{h_};
+  }
+};
+
+// suspend and have e resume the awaiting coroutine
+template <typename E>
+inline auto reschedule(E& e) noexcept
+{
+  return detail::reschedule_awaiter<E>{e};
+}
+
+// runs the work offloaded from the coroutines using a connection on a
+// thread of its own, a job at a time in the order offloaded, each holding
+// the connection's mutex, if it has one, so calls made on the connection
+// from other threads wait for the job instead of interleaving with it,
+// jobs still queued are run before the thread is joined
+class offloader
+{
+  sqlite3* const db_;
+
+  std::mutex m_;
+  std::condition_variable cv_;
+
+  std::deque<detail::offload_job*> q_;
+
+  bool stop_{};
+
+  std::thread t_;
+
+  void run()
+  {
+    for (std::unique_lock<std::mutex> l(m_);;)
+    {
+      cv_.wait(l, [&]() noexcept { return stop_ || !q_.empty(); });
+
+      if (q_.empty())
+      {
+        break;
+      }
+
+      auto const j(q_.front());
+      q_.pop_front();
+
+      l.unlock();
+
+      {
+        auto const m(sqlite3_db_mutex(db_));
+
+        sqlite3_mutex_enter(m);
+        j->run(*j);
+        sqlite3_mutex_leave(m);
+      }
+
+      // the coroutine may be resumed right away and free the job
+      j->resume(*j);
+
+      l.lock();
+    }
+  }
+
+public:
+  explicit offloader(sqlite3* const db) :
+    db_(db),
+    t_([this]() { run(); })
+  {
+  }
+
+  template <typename D, typename = std::enable_if_t<is_db_v<D>>>
+  explicit offloader(D const& db) :
+    offloader(db.get())
+  {
+  }
+
+  offloader(offloader const&) = delete;
+
+  ~offloader()
+  {
+    {
+      std::lock_guard<std::mutex> l(m_);
+
+      stop_ = true;
+    }
+
+    cv_.notify_one();
+
+    t_.join();
+  }
+
+  offloader& operator=(offloader const&) = delete;
+
+  auto db() const noexcept { return db_; }
+
+  void push(detail::offload_job& j)
+  {
+    {
+      std::lock_guard<std::mutex> l(m_);
+
+      assert(!stop_);
+      q_.push_back(&j);
+    }
+
+    cv_.notify_one();
+  }
+};
+
+template <typename E, typename F>
+inline void detail::offload_awaiter<E, F>::await_suspend(
+  std::coroutine_handle<> const c)
+{
+  h = c;
+
+  o.push(*this);
+}
+
+// run f on o's thread and have e resume the awaiting coroutine with its
+// result, for work that cannot be sliced
+template <typename E, typename F>
+inline auto offload(offloader& o, E& e, F&& f)
+{
+  return detail::offload_awaiter<E, std::decay_t<F>>(o, e,
+    std::decay_t<F>(std::forward<F>(f)));
+}
+
+// foreach_row() in slices of up to n rows, after each of which the
+// coroutine is rescheduled through e, a single step cannot be suspended,
+// the progress handler could only abort it, so a step that is slow on its
+// own still blocks, for those use offload()
+template <typename E, typename F>
+inline task<int> async_foreach_row(E& e, sqlite3_stmt* const s, F f,
+  std::size_t const n = 64)
+{
+  for (;;)
+  {
+    for (auto i(n); i; --i)
+    {
+      switch (auto const r(sqlite3_step(s)); r)
+      {
+        case SQLITE_ROW:
+          if (detail::call_row(s, f, detail::extract_signature(f)))
+          {
+            co_return r;
+          }
+
+          break;
+
+        case SQLITE_DONE:
+        case SQLITE_BUSY:
+        case SQLITE_LOCKED:
+        case SQLITE_INTERRUPT:
+          co_return r;
+
+        default:
+          assert(!"unhandled result from exec");
+          co_return r;
+      }
+    }
+
+    co_await reschedule(e);
+  }
+}
+
+// exec() and execget() offloaded to o, s must be of o's connection,
+// resuming through e
+template <int I = 1, typename E, typename ...A>
+inline task<int> async_exec(offloader& o, E& e, sqlite3_stmt* const s,
+  A ...args)
+{
+  assert(sqlite3_db_handle(s) == o.db());
+
+  co_return co_await offload(o, e, [&]() noexcept
+    {
+      return exec<I>(s, args...);
+    }
+  );
+}
+
+template <typename T, int I = 1, typename E, typename ...A>
+inline task<std::optional<T>> async_execget(offloader& o, E& e,
+  sqlite3_stmt* const s, int const i = 0, A ...args)
+{
+  assert(sqlite3_db_handle(s) == o.db());
+
+  co_return co_await offload(o, e, [&]()
+    {
+      return execget<T, I>(s, i, args...);
+    }
+  );
+}
+
+// forwarders, s must outlive the task
+template <typename E, typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto async_foreach_row(E& e, S const& s, A&& ...args)
+{
+  return async_foreach_row(e, s.get(), std::forward<A>(args)...);
+}
+
+template <int I = 1, typename E, typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto async_exec(offloader& o, E& e, S const& s, A&& ...args)
+{
+  return async_exec<I>(o, e, s.get(), std::forward<A>(args)...);
+}
+
+template <typename T, int I = 1, typename E, typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto async_execget(offloader& o, E& e, S const& s, A&& ...args)
+{
+  return async_execget<T, I>(o, e, s.get(), std::forward<A>(args)...);
+}
+#endif // SQU_ENABLE_COROUTINES && __cpp_impl_coroutine && __cpp_lib_coroutine
+
+
+//sharded_db//////////////////////////////////////////////////////////////////
+#if defined(SQU_ENABLE_SHARDED_DB)
+struct shard_options
+{
+  // most statements a writer commits in one transaction
+  std::size_t group{256};
+
+  int flags{SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE};
+
+  std::chrono::milliseconds busy_timeout{5000};
+};
+
+namespace detail
+{
+
+// exec_on() binds its arguments on a writer thread, after it returned, so
+// it keeps copies of what views and pointers point to
+template <enum encoding E>
+struct shard_text
+{
+  std::string v;
+  bool null;
+};
+
+template <enum encoding E>
+struct shard_text16
+{
+  std::u16string v;
+  bool null;
+};
+
+struct shard_blob
+{
+  std::vector<std::byte> v;
+
+  // of a zeroblob
+  sqlite3_uint64 zeros;
+};
+
+template <typename>
+struct pair_encoding;
+
+template <enum store S, enum encoding E>
+struct pair_encoding<charpair<S, E>> : std::integral_constant<encoding, E> {};
+
+template <enum store S, enum encoding E>
+struct pair_encoding<char16pair<S, E>> :
+  std::integral_constant<encoding, E> {};
+
+template <typename>
+struct is_blobpair : std::false_type {};
+
+template <enum store S>
+struct is_blobpair<blobpair<S>> : std::true_type {};
+
+template <typename>
+struct is_span : std::false_type {};
+
+#if defined(__cpp_lib_span)
+template <typename T, std::size_t N>
+struct is_span<std::span<T, N>> : std::true_type {};
+#endif // __cpp_lib_span
+
+template <typename A>
+inline auto shard_own(A&& a)
+{
+  using T = std::decay_t<A>;
+
+  if constexpr (std::is_same_v<T, char*> || std::is_same_v<T, char const*>)
+  {
+    return shard_text<UTF8>{a ? a : "", !a};
+  }
+  else if constexpr (std::is_same_v<T, char16_t*> ||
+    std::is_same_v<T, char16_t const*>)
+  {
+    return shard_text16<UTF16>{a ? a : u"", !a};
+  }
+  else if constexpr (std::is_same_v<T, std::string_view>)
+  {
+    return shard_text<UTF8>{std::string(a), false};
+  }
+  else if constexpr (std::is_same_v<T, std::u16string_view>)
+  {
+    return shard_text16<UTF16>{std::u16string(a), false};
+  }
+  else if constexpr (is_charpair<T>{})
+  {
+    return shard_text<pair_encoding<T>::value>{
+      a.first ? std::string(a.first, a.second) : std::string(), !a.first};
+  }
+  else if constexpr (is_char16pair<T>{})
+  {
+    return shard_text16<pair_encoding<T>::value>{
+      a.first ? std::u16string(a.first, a.second) : std::u16string(),
+      !a.first};
+  }
+  else if constexpr (is_blobpair<T>{})
+  {
+    auto const p(static_cast<std::byte const*>(a.first));
+
+    return shard_blob{p ? std::vector<std::byte>(p, p + a.second) :
+      std::vector<std::byte>(), p ? 0 : a.second};
+  }
+  else if constexpr (is_span<T>{})
+  {
+    auto const p(reinterpret_cast<std::byte const*>(a.data()));
+
+    return shard_blob{std::vector<std::byte>(p, p + a.size_bytes()), 0};
+  }
+  else
+  {
+    static_assert(!std::is_pointer_v<T>,
+      "exec_on() cannot copy what the pointer points to");
+
+    return T(std::forward<A>(a));
+  }
+}
+
+// bind the copies without copying them again, they outlive the binding
+template <typename T>
+inline auto const& shard_view(T const& v) noexcept
+{
+  return v;
+}
+
+template <enum encoding E>
+inline auto shard_view(shard_text<E> const& t) noexcept
+{
+  return charpair<STATIC, E>{t.null ? nullptr : t.v.data(), t.v.size()};
+}
+
+template <enum encoding E>
+inline auto shard_view(shard_text16<E> const& t) noexcept
+{
+  return char16pair<STATIC, E>{t.null ? nullptr : t.v.data(), t.v.size()};
+}
+
+inline auto shard_view(shard_blob const& b) noexcept
+{
+  return b.v.empty() ? blobpair<STATIC>{nullptr, b.zeros} :
+    blobpair<STATIC>{b.v.data(), b.v.size()};
+}
+
+}
+
+// routes writes by key hash to one of several database files, each of which
+// has a writer thread that commits whatever has queued up for it in one
+// transaction, reads can be scattered over all shards and gathered
+class sharded_db
+{
+  struct job
+  {
+    std::function<int(sqlite3*, std::unordered_map<std::string,
+      unique_stmt_t>&)> f;
+    std::promise<int> p;
+  };
+
+  struct shard
+  {
+    unique_db_t writer;
+    unique_db_t reader;
+
+    // of the writer thread and of reads respectively
+    std::unordered_map<std::string, unique_stmt_t> wcache;
+    std::unordered_map<std::string, unique_stmt_t> rcache;
+
+    std::mutex rm;
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::vector<job> q;
+    bool stop{};
+
+    std::thread t;
+  };
+
+  shard_options const o_;
+
+  std::vector<std::unique_ptr<shard>> s_;
+
+  // of opening the shards, the first failure
+  int open_{SQLITE_OK};
+
+  // prepare sql persistently, or take it from c
+  static sqlite3_stmt* cached(sqlite3* const db,
+    std::unordered_map<std::string, unique_stmt_t>& c,
+    std::string const& sql, int& r)
+  {
+    auto& s(c[sql]);
+
+    if (!s)
+    {
+      sqlite3_stmt* p;
+
+      if (SQLITE_OK != (r = sqlite3_prepare_v3(db, sql.data(), sql.size(),
+        SQLITE_PREPARE_PERSISTENT, &p, nullptr)))
+      {
+        c.erase(sql);
+
+        return nullptr;
+      }
+
+      s.reset(p);
+    }
+
+    return s.get();
+  }
+
+  void write(shard& s)
+  {
+    for (std::vector<job> b;;)
+    {
+      {
+        std::unique_lock<std::mutex> l(s.m);
+
+        s.cv.wait(l, [&]() noexcept { return s.stop || !s.q.empty(); });
+
+        if (s.q.empty())
+        {
+          break;
+        }
+
+        auto const n(std::min(s.q.size(), std::max(o_.group,
+          std::size_t(1))));
+
+        b.assign(std::make_move_iterator(s.q.begin()),
+          std::make_move_iterator(s.q.begin() + n));
+        s.q.erase(s.q.begin(), s.q.begin() + n);
+      }
+
+      auto const db(s.writer.get());
+
+      std::vector<int> r(b.size());
+
+      for (std::size_t i{}; i != b.size();)
+      {
+        // group commit, a statement that fails is rolled back on its own
+        bool const tx((b.size() - i > 1) && sqlite3_get_autocommit(db) &&
+          (SQLITE_OK == sqlite3_exec(db, "BEGIN IMMEDIATE", nullptr, nullptr,
+            nullptr)));
+
+        auto const first(i);
+
+        for (; (i != b.size()) && (!tx || !sqlite3_get_autocommit(db)); ++i)
+        {
+          r[i] = b[i].f(db, s.wcache);
+        }
+
+        if (!tx)
+        {
+          continue;
+        }
+
+        if (sqlite3_get_autocommit(db))
+        {
+          // unless a failure (SQLITE_FULL, OR ROLLBACK, RAISE(ROLLBACK), ...)
+          // rolled back the whole transaction, the jobs before it included,
+          // the rest of the group then goes in a new one
+          if (SQLITE_DONE != r[i - 1])
+          {
+            std::fill(r.begin() + first, r.begin() + (i - 1),
+              SQLITE_ABORT_ROLLBACK);
+          }
+        }
+        else if (auto const c(sqlite3_exec(db, "COMMIT", nullptr, nullptr,
+          nullptr)); SQLITE_OK != c)
+        {
+          sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+
+          std::fill(r.begin() + first, r.begin() + i, c);
+        }
+      }
+
+      for (std::size_t i{}; i != b.size(); ++i)
+      {
+        b[i].p.set_value(r[i]);
+      }
+
+      b.clear();
+    }
+  }
+
+public:
+  // open a shard for each of the files, in WAL mode, check size() and
+  // ok() for failures
+  explicit sharded_db(std::vector<std::string> const& files,
+    shard_options const& o = {}) :
+    o_(o)
+  {
+    for (auto& f: files)
+    {
+      auto& s(*s_.emplace_back(std::make_unique<shard>()));
+
+      for (auto const db: {&s.writer, &s.reader})
+      {
+        sqlite3* p;
+
+        if (auto const r(sqlite3_open_v2(f.c_str(), &p, o.flags, nullptr));
+          SQLITE_OK == r)
+        {
+          sqlite3_busy_timeout(p, int(o.busy_timeout.count()));
+          sqlite3_exec(p, "PRAGMA journal_mode=WAL", nullptr, nullptr,
+            nullptr);
+        }
+        else if (SQLITE_OK == open_)
+        {
+          open_ = r;
+        }
+
+        db->reset(p);
+      }
+
+      s.t = std::thread(&sharded_db::write, this, std::ref(s));
+    }
+  }
+
+  sharded_db(sharded_db const&) = delete;
+
+  // queued writes are completed first
+  ~sharded_db()
+  {
+    for (auto& s: s_)
+    {
+      {
+        std::lock_guard<std::mutex> l(s->m);
+        s->stop = true;
+      }
+
+      s->cv.notify_one();
+      s->t.join();
+    }
+  }
+
+  sharded_db& operator=(sharded_db const&) = delete;
+
+  auto size() const noexcept { return s_.size(); }
+
+  // all shards could be opened, as recorded when they were, the writer
+  // threads use the connections since
+  bool ok() const noexcept { return SQLITE_OK == open_; }
+
+  // why a shard could not be opened
+  auto result() const noexcept { return open_; }
+
+  template <typename K>
+  std::size_t route(K const& k) const noexcept
+  {
+    assert(!s_.empty());
+
+    return std::hash<K>()(k) % s_.size();
+  }
+
+  // queue sql, bound to args, on shard i, the future yields the result of
+  // the last step, SQLITE_DONE on success, or SQLITE_ABORT_ROLLBACK if a
+  // later statement of its group rolled the transaction back, the arguments
+  // are bound once the writer gets to them, so strings and blobs they view
+  // are copied, other pointers are rejected
+  template <typename ...A>
+  std::future<int> exec_on(std::size_t const i, std::string_view const& sql,
+    A&& ...args)
+  {
+    job j{
+      [sql = std::string(sql),
+        a = std::make_tuple(detail::shard_own(std::forward<A>(args))...)](
+        sqlite3* const db, auto& c)
+      {
+        int r;
+
+        auto const s(cached(db, c, sql, r));
+
+        if (!s)
+        {
+          return r;
+        }
+
+        if constexpr (bool(sizeof...(A)))
+        {
+          if ((r = std::apply([s](auto const& ...v) noexcept
+            {
+              return squ::set(s, detail::shard_view(v)...);
+            }, a)) != SQLITE_OK)
+          {
+            sqlite3_clear_bindings(s);
+
+            return r;
+          }
+        }
+
+        while (SQLITE_ROW == (r = sqlite3_step(s)));
+
+        sqlite3_reset(s);
+
+        // the copies go with the job
+        sqlite3_clear_bindings(s);
+
+        return r;
+      },
+      {}
+    };
+
+    assert(i < s_.size());
+
+    auto f(j.p.get_future());
+
+    auto& s(*s_[i]);
+
+    {
+      std::lock_guard<std::mutex> l(s.m);
+      s.q.push_back(std::move(j));
+    }
+
+    s.cv.notify_one();
+
+    return f;
+  }
+
+  // queue sql on the shard of key k
+  template <typename K, typename ...A>
+  auto exec(K const& k, std::string_view const& sql, A&& ...args)
+  {
+    return exec_on(route(k), sql, std::forward<A>(args)...);
+  }
+
+  // queue sql on every shard, e.g. to create the schema
+  template <typename ...A>
+  auto exec_all(std::string_view const& sql, A const& ...args)
+  {
+    std::vector<std::future<int>> r;
+
+    for (std::size_t i{}; i != s_.size(); ++i)
+    {
+      r.push_back(exec_on(i, sql, args...));
+    }
+
+    return r;
+  }
+
+  // run sql on every shard in parallel, appending the rows, from column i
+  // on, to c, shard by shard, returns SQLITE_DONE or the first failure
+  template <typename C, typename ...A>
+  int gather(C& c, std::string_view const& sql, int const i = 0,
+    A const& ...args)
+  {
+    std::vector<C> v(s_.size());
+    std::vector<int> r(s_.size());
+
+    {
+      std::vector<std::thread> t;
+
+      for (std::size_t k{}; k != s_.size(); ++k)
+      {
+        t.emplace_back([&, k]()
+          {
+            auto& s(*s_[k]);
+
+            std::lock_guard<std::mutex> l(s.rm);
+
+            auto const p(cached(s.reader.get(), s.rcache, std::string(sql),
+              r[k]));
+
+            if (!p)
+            {
+              return;
+            }
+
+            if constexpr (bool(sizeof...(A)))
+            {
+              if (SQLITE_OK != (r[k] = squ::set(p, args...)))
+              {
+                return;
+              }
+            }
+
+            r[k] = emplace_back(p, v[k], i);
+
+            sqlite3_reset(p);
+          }
+        );
+      }
+
+      for (auto& th: t)
+      {
+        th.join();
+      }
+    }
+
+    for (std::size_t k{}; k != s_.size(); ++k)
+    {
+      if (SQLITE_DONE != r[k])
+      {
+        return r[k];
+      }
+
+      c.insert(c.end(), std::make_move_iterator(v[k].begin()),
+        std::make_move_iterator(v[k].end()));
+    }
+
+    return SQLITE_DONE;
+  }
+};
+#endif // SQU_ENABLE_SHARDED_DB
+
+
+//get_span////////////////////////////////////////////////////////////////////
+#if defined(__cpp_lib_span)
+// get<std::span<T const>>(), but a blob that cannot be viewed in place for
+// being misaligned is copied into b, the blob size must be a multiple of
+// sizeof(T)
+template <typename T>
+inline std::enable_if_t<
+  std::is_trivially_copyable_v<T>,
+  std::span<T const>
+>
+get_span(sqlite3_stmt* const s, int const i, std::vector<T>& b)
+{
+  auto const p(sqlite3_column_blob(s, i));
+  std::size_t const n(sqlite3_column_bytes(s, i));
+
+  assert(!p || !(n % sizeof(T)));
+
+  if (!p || (n % sizeof(T)))
+  {
+    return {};
+  }
+  else if (reinterpret_cast<std::uintptr_t>(p) % alignof(T))
+  {
+    b.resize(n / sizeof(T));
+    std::memcpy(b.data(), p, n);
+
+    return b;
+  }
+  else
+  {
+    return {static_cast<T const*>(p), n / sizeof(T)};
+  }
+}
+
+// forwarders
+template <typename T, typename S,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto get_span(S const& s, int const i, std::vector<T>& b)
+{
+  return get_span(s.get(), i, b);
+}
+#endif // __cpp_lib_span
+
+
+//bind_scope//////////////////////////////////////////////////////////////////
+namespace detail
+{
+
+// strings and blobs as their STATIC pairs, anything else as is
+template <typename T>
+inline decltype(auto) as_static(T const& v) noexcept
+{
+  if constexpr (std::is_same_v<T, std::string> ||
+    std::is_same_v<T, std::string_view>)
+  {
+    return charpair<STATIC>{v.data(), v.size()};
+  }
+  else if constexpr (std::is_same_v<T, char const*> ||
+    std::is_same_v<T, char*>)
+  {
+    return charpair<STATIC>{v, v ? std::strlen(v) : 0};
+  }
+  else if constexpr (std::is_same_v<T, std::u16string> ||
+    std::is_same_v<T, std::u16string_view>)
+  {
+    return char16pair<STATIC>{v.data(), v.size()};
+  }
+  else if constexpr (std::is_same_v<T, blobpair<TRANSIENT>>)
+  {
+    return blobpair<STATIC>{v.first, v.second};
+  }
+  else
+  {
+    return (v);
+  }
+}
+
+// a temporary string, which would be gone while still bound
+template <typename A>
+inline constexpr bool is_string_rvalue_v{!std::is_reference_v<A> &&
+  (std::is_same_v<remove_cvr_t<A>, std::string> ||
+  std::is_same_v<remove_cvr_t<A>, std::u16string>)};
+
+}
+
+// binds strings and blobs SQLITE_STATIC, without sqlite copying them, and
+// resets the statement and clears its bindings as the scope ends, so that
+// nothing is left pointing at them, the bound values must outlive the scope
+class bind_scope
+{
+  sqlite3_stmt* const s_;
+
+public:
+  explicit bind_scope(sqlite3_stmt* const s) noexcept : s_(s) { }
+
+  template <typename S, typename = std::enable_if_t<is_stmt_v<S>>>
+  explicit bind_scope(S const& s) noexcept : s_(s.get()) { }
+
+  bind_scope(bind_scope const&) = delete;
+
+  ~bind_scope()
+  {
+    sqlite3_reset(s_);
+    sqlite3_clear_bindings(s_);
+  }
+
+  bind_scope& operator=(bind_scope const&) = delete;
+
+  // temporary strings are rejected, they would not outlive the scope
+  template <int I = 1, typename ...A,
+    typename = std::enable_if_t<!(detail::is_string_rvalue_v<A> || ...)>
+  >
+  auto set(A&& ...args) const noexcept
+  {
+    return squ::set<I>(s_, detail::as_static(args)...);
+  }
+
+  template <int I = 1, typename ...A,
+    typename = std::enable_if_t<!(detail::is_string_rvalue_v<A> || ...)>
+  >
+  auto exec(A&& ...args) const noexcept
+  {
+    return squ::exec<I>(s_, detail::as_static(args)...);
+  }
+};
+
+//exec_static/////////////////////////////////////////////////////////////////
+// reset s, bind args SQLITE_STATIC and step it to completion, discarding
+// any rows, then reset it and clear its bindings again, for statements run
+// for their side effects, as nothing stays bound once it returns, args can
+// be temporaries
+template <int I = 1, typename ...A>
+inline auto exec_static(sqlite3_stmt* const s, A const& ...args) noexcept
+{
+  sqlite3_reset(s);
+
+  bind_scope const b(s);
+
+  auto r(b.exec<I>(args...));
+
+  while (SQLITE_ROW == r)
+  {
+    r = sqlite3_step(s);
+  }
+
+  return r;
+}
+
+// forwarders
+template <int I = 1, typename S, typename ...A,
+  typename = std::enable_if_t<is_stmt_v<S>>
+>
+inline auto exec_static(S const& s, A const& ...args) noexcept
+{
+  return exec_static<I>(s.get(), args...);
+}
+
+}
+
+// SQU_SQL("SELECT a, b FROM t WHERE c = ?") makes a squ::sql<1, 2>, the
+// literal must be a string literal or another constant expression
+#define SQU_SQL(s) \
+  ([]() noexcept \
+    { \
+      constexpr std::string_view sv(s); \
+      return ::squ::sql< \
+        ::squ::detail::count_params(sv), \
+        ::squ::detail::count_columns(sv) \
+      >{sv}; \
+    }())
 
 #endif // SQLITEUTILS_HPP
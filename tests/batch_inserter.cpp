@@ -0,0 +1,76 @@
+#include "test.hpp"
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a INTEGER UNIQUE, b TEXT)"));
+
+  // full batches and a remainder of every smaller power of two
+  {
+    squ::batch_inserter<8, int, std::string> b(db, "INSERT INTO t(a, b)");
+    CHECK(8 == b.batch_size());
+
+    for (int i{}; i != 23; ++i)
+    {
+      CHECK(SQLITE_OK == b.insert(i, std::to_string(i)));
+    }
+
+    CHECK(7 == b.size());
+    CHECK(SQLITE_OK == b.flush());
+    CHECK(!b.size());
+  }
+
+  CHECK(23 == squ::execget<int>(db, "SELECT count(*) FROM t").value());
+  CHECK(!squ::execget<int>(db, "SELECT count(*) FROM t WHERE b != a")
+    .value());
+
+  // the batch size is lowered to the variable limit
+  {
+    sqlite3_limit(db.get(), SQLITE_LIMIT_VARIABLE_NUMBER, 10);
+
+    squ::batch_inserter<64, int, std::string> b(db, "INSERT INTO t(a, b)");
+    CHECK(4 == b.batch_size());
+
+    sqlite3_limit(db.get(), SQLITE_LIMIT_VARIABLE_NUMBER, 32766);
+  }
+
+  squ::execmulti(db, std::string("DELETE FROM t; INSERT INTO t VALUES(5, '')"));
+
+  // rows that failed to insert stay buffered and the flush can be retried
+  {
+    squ::batch_inserter<4, int, std::nullptr_t> b(db, "INSERT INTO t(a, b)");
+
+    for (int i{}; i != 7; ++i)
+    {
+      b.insert(i, nullptr);
+    }
+
+    CHECK(3 == b.size());
+    CHECK(SQLITE_CONSTRAINT == b.flush());
+    CHECK(3 == b.size());
+
+    squ::execmulti(db, std::string("DELETE FROM t WHERE a = 5"));
+
+    CHECK(SQLITE_OK == b.flush());
+    CHECK(!b.size());
+
+    // the destructor ignores the failure of the last flush
+    b.insert(1, nullptr);
+  }
+
+  CHECK(7 == squ::execget<int>(db, "SELECT count(*) FROM t").value());
+
+  // a bad head is reported, not asserted
+  {
+    squ::batch_inserter<2, int> b(db, "INSERT INTO nope(a)");
+
+    b.insert(1);
+    CHECK(SQLITE_ERROR == b.insert(2));
+    CHECK(2 == b.size());
+
+    b.clear();
+  }
+
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include "test.hpp"
+
+namespace
+{
+
+template <typename A, typename = void>
+struct can_set : std::false_type {};
+
+template <typename A>
+struct can_set<A, std::void_t<
+  decltype(std::declval<squ::bind_scope const&>().set(std::declval<A>())),
+  decltype(std::declval<squ::bind_scope const&>().exec(std::declval<A>()))>
+> : std::true_type {};
+
+}
+
+// temporary strings would be gone while bound, views leave that to the caller
+static_assert(!can_set<std::string>{});
+static_assert(!can_set<std::string const>{});
+static_assert(!can_set<std::u16string>{});
+static_assert(can_set<std::string&>{});
+static_assert(can_set<std::string const&>{});
+static_assert(can_set<std::string_view>{});
+static_assert(can_set<char const*>{});
+static_assert(can_set<int>{});
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a, b)"));
+
+  auto const s(squ::make_unique(db, "SELECT ?, ?"));
+
+  {
+    std::string const a("a");
+    std::u16string const b(u"b");
+
+    squ::bind_scope const g(s);
+
+    CHECK(SQLITE_ROW == g.exec(a, b));
+
+    CHECK("a" == squ::get<std::string>(s, 0));
+    CHECK("b" == squ::get<std::string>(s, 1));
+  }
+
+  // nothing stays bound once the scope ends
+  CHECK(SQLITE_ROW == squ::exec(s));
+  CHECK(SQLITE_NULL == sqlite3_column_type(s.get(), 0));
+  CHECK(SQLITE_NULL == sqlite3_column_type(s.get(), 1));
+
+  // exec_static clears its bindings before returning, so temporaries do
+  auto const i(squ::make_unique(db, "INSERT INTO t VALUES(?, ?)"));
+
+  CHECK(SQLITE_DONE == squ::exec_static(i, std::string(64, 'x'),
+    std::u16string(u"y")));
+  CHECK(SQLITE_DONE == squ::exec_static(i, 1, 2));
+
+  CHECK(SQLITE_ROW == squ::rexec(s));
+  CHECK(SQLITE_NULL == sqlite3_column_type(s.get(), 0));
+
+  CHECK(std::string(64, 'x') + "y" ==
+    squ::execget<std::string>(db, "SELECT a || b FROM t WHERE rowid = 1")
+      .value());
+  CHECK(3 == squ::execget<int>(db, "SELECT a + b FROM t WHERE rowid = 2")
+    .value());
+
+  return 0;
+}
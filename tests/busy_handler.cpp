@@ -0,0 +1,120 @@
+#include <numeric>
+#include <thread>
+
+#include "test.hpp"
+
+using namespace std::chrono_literals;
+
+int main()
+{
+  std::remove("busy_handler.db");
+
+  {
+    auto const a(squ::open_unique("busy_handler.db",
+      SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE));
+    auto const b(squ::open_unique("busy_handler.db", SQLITE_OPEN_READWRITE));
+
+    squ::execmulti(a, std::string(
+      "CREATE TABLE t(x); INSERT INTO t VALUES(1)"));
+
+    squ::busy_config cfg;
+    cfg.deadline = 50ms;
+
+    squ::busy_handler h(b, cfg);
+
+    auto const s(squ::make_unique(b, "SELECT x FROM t"));
+
+    // a lock held past the deadline lets SQLITE_BUSY through
+    squ::execmulti(a, std::string("BEGIN EXCLUSIVE"));
+
+    auto const start(std::chrono::steady_clock::now());
+
+    CHECK(SQLITE_BUSY == squ::foreach_row(s, [](int) noexcept {}));
+    CHECK(std::chrono::steady_clock::now() - start >= cfg.deadline);
+
+    CHECK((1 == h.waits()) && (1 == h.timeouts()));
+
+    // the wait is counted once, in the bucket of its length, [2^15, 2^16)
+    // us for 50 ms, or the next on a loaded machine
+    {
+      auto const hi(h.histogram());
+
+      CHECK(1 == std::accumulate(hi.begin(), hi.end(), std::uint64_t()));
+      CHECK(1 == hi[16] + hi[17]);
+    }
+
+    // one released in time is waited out
+    squ::reset(s);
+
+    std::thread t([&]()
+      {
+        std::this_thread::sleep_for(10ms);
+        squ::execmulti(a, std::string("COMMIT"));
+      }
+    );
+
+    int x{};
+
+    CHECK(SQLITE_DONE == squ::foreach_row(s, [&](int const v) noexcept
+      {
+        x = v;
+      }
+    ));
+
+    t.join();
+
+    CHECK(1 == x);
+    CHECK((2 == h.waits()) && (1 == h.timeouts()));
+
+    {
+      auto const hi(h.histogram());
+
+      CHECK(2 == std::accumulate(hi.begin(), hi.end(), std::uint64_t()));
+    }
+  }
+
+  std::remove("busy_handler.db");
+
+#if defined(SQLITE_ENABLE_UNLOCK_NOTIFY)
+  // on a shared cache, a table locked by another connection's transaction
+  // is waited for rather than failing with SQLITE_LOCKED
+  {
+    auto const open([](int const fl)
+      {
+        return squ::open_unique("file:busy_handler?mode=memory&cache=shared",
+          SQLITE_OPEN_READWRITE | SQLITE_OPEN_URI | fl);
+      }
+    );
+
+    auto const c(open(SQLITE_OPEN_CREATE)), d(open(0));
+
+    squ::execmulti(c, std::string("CREATE TABLE u(x); INSERT INTO u VALUES(7);"
+      "BEGIN; INSERT INTO u VALUES(8)"));
+
+    auto const q(squ::make_unique(d, "SELECT count(*) FROM u"));
+
+    CHECK(SQLITE_LOCKED == sqlite3_step(q.get()));
+    squ::reset(q);
+
+    std::thread t([&]()
+      {
+        std::this_thread::sleep_for(20ms);
+        squ::execmulti(c, std::string("COMMIT"));
+      }
+    );
+
+    CHECK(SQLITE_ROW == squ::blocking_step(q));
+    CHECK(2 == squ::get<int>(q));
+
+    t.join();
+
+    // other errors come back as they are
+    auto const e(squ::make_unique(d, "SELECT abs(?)"));
+
+    CHECK(SQLITE_OK == squ::set(e, std::numeric_limits<std::int64_t>::min()));
+    CHECK(SQLITE_ERROR == squ::blocking_step(e));
+  }
+#endif // SQLITE_ENABLE_UNLOCK_NOTIFY
+
+  return 0;
+}
@@ -0,0 +1,286 @@
+#include <thread>
+
+#include "test.hpp"
+
+namespace
+{
+
+auto drain(squ::change_stream& cs)
+{
+  std::vector<squ::change> r;
+
+  cs.drain([&](squ::change&& c) { r.push_back(std::move(c)); });
+
+  return r;
+}
+
+}
+
+int main()
+{
+  // the ring is bounded, capacities are rounded up to a power of 2
+  {
+    squ::ring_buffer<int> rb(3);
+
+    CHECK(4 == rb.capacity());
+
+    for (int i{}; i != 4; ++i)
+    {
+      CHECK(rb.try_push(i));
+    }
+
+    CHECK(!rb.try_push(4));
+    CHECK(4 == rb.size());
+
+    int v;
+
+    for (int i{}; i != 4; ++i)
+    {
+      CHECK(rb.try_pop(v) && (i == v));
+    }
+
+    CHECK(!rb.try_pop(v));
+  }
+
+  // and takes values from several producers
+  {
+    squ::ring_buffer<int> rb(64);
+
+    std::vector<std::thread> p;
+
+    for (int i{}; i != 4; ++i)
+    {
+      p.emplace_back([&]()
+        {
+          for (int j{}; j != 10000; ++j)
+          {
+            while (!rb.try_push(j))
+            {
+              std::this_thread::yield();
+            }
+          }
+        }
+      );
+    }
+
+    long long sum{};
+
+    for (int n{}, v; n != 40000;)
+    {
+      if (rb.try_pop(v))
+      {
+        sum += v;
+        ++n;
+      }
+    }
+
+    for (auto& t: p)
+    {
+      t.join();
+    }
+
+    CHECK(4 * 9999LL * 10000 / 2 == sum);
+  }
+
+  std::remove("change_stream.db");
+
+  auto const db(squ::open_unique("change_stream.db",
+    SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE));
+
+  squ::execmulti(db, std::string(
+    "CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT)"));
+
+  // changes are published once their transaction has committed
+  {
+    squ::change_stream cs(16);
+    cs.attach(db);
+
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "BEGIN; INSERT INTO t VALUES(1, 'a'), (2, 'b')")));
+    CHECK(drain(cs).empty());
+
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "UPDATE t SET name = 'x', id = 5 WHERE id = 1; COMMIT")));
+
+    auto const c(drain(cs));
+
+    CHECK(3 == c.size());
+    CHECK((SQLITE_INSERT == c[0].op) && (1 == c[0].rowid));
+    CHECK((SQLITE_INSERT == c[1].op) && (2 == c[1].rowid));
+    CHECK(("main" == c[2].db) && ("t" == c[2].table));
+    CHECK(SQLITE_UPDATE == c[2].op);
+
+#if defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+    CHECK((1 == c[2].rowid) && (5 == c[2].new_rowid));
+    CHECK(std::get<std::string>(c[2].old_values[1]) == "a");
+    CHECK(std::get<std::string>(c[2].new_values[1]) == "x");
+    CHECK(c[0].old_values.empty());
+#endif // SQLITE_ENABLE_PREUPDATE_HOOK
+
+    // rolled back changes never are
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "BEGIN; DELETE FROM t; ROLLBACK")));
+    CHECK(drain(cs).empty());
+
+    // nor are those of a failed statement inside an implicit transaction
+    CHECK(SQLITE_OK != squ::execmulti(db, std::string(
+      "INSERT INTO t VALUES(7, 'g'), (5, 'dup')")));
+    CHECK(drain(cs).empty());
+
+    // nor those undone by a rollback to a savepoint, or by the failure of a
+    // statement inside an open transaction, which keeps its other changes
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "BEGIN; INSERT INTO t VALUES(30, 'a'); SAVEPOINT sp;"
+      "INSERT INTO t VALUES(31, 'b'); SAVEPOINT \"Inner\";"
+      "DELETE FROM t WHERE id = 30; ROLLBACK TO sp; RELEASE sp")));
+    CHECK(SQLITE_CONSTRAINT == squ::execmulti(db, std::string(
+      "INSERT INTO t VALUES(32, 'c'), (30, 'dup')")));
+    CHECK(SQLITE_CONSTRAINT == squ::execmulti(db, std::string(
+      "INSERT OR FAIL INTO t VALUES(33, 'd'), (30, 'dup')")));
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "SAVEPOINT a; INSERT INTO t VALUES(34, 'e'); RELEASE a;"
+      "SAVEPOINT b; INSERT INTO t VALUES(35, 'f');"
+      "ROLLBACK TRANSACTION TO SAVEPOINT B; COMMIT")));
+
+    // a savepoint outside a transaction opens one
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "SAVEPOINT a; INSERT INTO t VALUES(36, 'g'); ROLLBACK TO a;"
+      "INSERT INTO t VALUES(37, 'h'); RELEASE a")));
+
+    {
+      std::string ids;
+
+      for (auto& c: drain(cs))
+      {
+        ids += std::to_string(c.rowid) + ' ';
+      }
+
+      CHECK("30 33 34 37 " == ids);
+      CHECK("30 33 34 37" == squ::execget<std::string>(db,
+        "SELECT group_concat(id, ' ') FROM t WHERE id >= 30").value());
+    }
+
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "DELETE FROM t WHERE id >= 30")));
+    CHECK(4 == drain(cs).size());
+
+    // a commit failing with SQLITE_BUSY leaves the transaction open, its
+    // changes wait for the retry
+    auto const rd(squ::open_unique("change_stream.db", SQLITE_OPEN_READWRITE));
+    auto const r(squ::make_unique(rd, "SELECT id FROM t"));
+
+    for (auto const& [end, n]: {std::pair("COMMIT", 1), {"ROLLBACK", 0}})
+    {
+      CHECK(SQLITE_ROW == squ::exec(r));
+      CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+        "BEGIN; INSERT INTO t VALUES(NULL, '") + end + "')"));
+      CHECK(SQLITE_BUSY == squ::execmulti(db, std::string("COMMIT")));
+      CHECK(drain(cs).empty());
+
+      squ::reset(r);
+
+      CHECK(SQLITE_OK == squ::execmulti(db, std::string(end)));
+      CHECK(std::size_t(n) == drain(cs).size());
+    }
+
+    cs.detach(db);
+  }
+
+  // a full ring drops what does not fit
+  {
+    squ::change_stream cs(4, squ::DROP);
+    cs.attach(db);
+
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "INSERT INTO t VALUES(10, 'a'), (11, 'b'), (12, 'c'), (13, 'd'),"
+      "(14, 'e'), (15, 'f')")));
+    CHECK(2 == cs.dropped());
+    CHECK(4 == drain(cs).size());
+
+    cs.detach(db);
+  }
+
+  // or rolls back the transactions that do not
+  {
+    squ::change_stream cs(4, squ::ABORT);
+    cs.attach(db);
+
+    auto const n(squ::execget<int>(db, "SELECT count(*) FROM t").value());
+
+    CHECK(SQLITE_OK != squ::execmulti(db, std::string(
+      "INSERT INTO t VALUES(20, 'a'), (21, 'b'), (22, 'c'), (23, 'd'),"
+      "(24, 'e')")));
+    CHECK(1 == cs.aborted());
+    CHECK(n == squ::execget<int>(db, "SELECT count(*) FROM t").value());
+    CHECK(drain(cs).empty());
+
+    // those that fit exactly commit
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "DELETE FROM t WHERE id BETWEEN 10 AND 13")));
+    CHECK(4 == drain(cs).size());
+
+    cs.detach(db);
+  }
+
+  // or waits for the consumers
+  {
+    squ::change_stream cs(4);
+    cs.attach(db);
+
+    std::atomic<bool> done{};
+    std::size_t n{};
+
+    std::thread c([&]()
+      {
+        while (!done || n != 100)
+        {
+          n += cs.drain([](squ::change&&) noexcept {});
+        }
+      }
+    );
+
+    for (int i{}; i != 10; ++i)
+    {
+      CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+        "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c "
+        "WHERE x < 10) INSERT INTO t SELECT NULL, x FROM c")));
+    }
+
+    done = true;
+    c.join();
+
+    CHECK(100 == n);
+    CHECK(!cs.dropped() && !cs.aborted() && !cs.lost());
+
+    cs.detach(db);
+  }
+
+  // the commit hook and trace callback are shared with the other components
+  {
+    squ::change_stream cs(16);
+    squ::result_cache rc;
+
+    cs.attach(db);
+    rc.attach(db);
+
+    auto const q(squ::make_unique(db, "SELECT count(*) FROM t"));
+    auto const n(squ::cached_rexecget<int>(rc, q).value());
+
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "INSERT INTO t VALUES(NULL, 'x')")));
+    CHECK(1 == drain(cs).size());
+    CHECK(n + 1 == squ::cached_rexecget<int>(rc, q).value());
+
+    rc.detach(db);
+
+    CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+      "DELETE FROM t WHERE id = (SELECT max(id) FROM t)")));
+    CHECK(1 == drain(cs).size());
+
+    cs.detach(db);
+  }
+
+  std::remove("change_stream.db");
+
+  return 0;
+}
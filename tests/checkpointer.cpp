@@ -0,0 +1,125 @@
+#include <thread>
+
+#include "test.hpp"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+template <typename F>
+bool eventually(F const f)
+{
+  for (int i{}; i != 500; ++i)
+  {
+    if (f())
+    {
+      return true;
+    }
+
+    std::this_thread::sleep_for(10ms);
+  }
+
+  return false;
+}
+
+}
+
+int main()
+{
+  for (auto const s: {"", "-wal", "-shm"})
+  {
+    std::remove((std::string("checkpointer.db") + s).c_str());
+  }
+
+  {
+    auto const db(squ::open_unique("checkpointer.db",
+      SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE));
+
+    squ::execmulti(db, std::string(
+      "PRAGMA journal_mode=WAL; CREATE TABLE t(a)"));
+
+    auto const page(squ::execget<int>(db, "PRAGMA page_size").value());
+
+    // RESTART and TRUNCATE checkpoints hold the write lock while they run
+    sqlite3_busy_timeout(db.get(), 5000);
+
+    squ::checkpoint_config cfg;
+    cfg.passive = 10;
+    cfg.restart = 50;
+    cfg.truncate = 200;
+
+    {
+      squ::checkpointer c("checkpointer.db", cfg);
+      CHECK(c);
+
+      c.attach(db);
+
+      auto const s(squ::make_unique(db,
+        "INSERT INTO t VALUES(zeroblob(3000))"));
+
+      // below the passive threshold nothing happens
+      CHECK(SQLITE_DONE == squ::rexec(s));
+
+      std::this_thread::sleep_for(20ms);
+
+      CHECK(c.wal_frames() && (c.wal_frames() < cfg.passive));
+      CHECK(!c.stats().count);
+
+      // past it the wal is checkpointed in the background, by the mode its
+      // size calls for
+      for (int i{}; i != 500; ++i)
+      {
+        CHECK(SQLITE_DONE == squ::rexec(s));
+      }
+
+      CHECK(eventually([&]() noexcept
+        {
+          auto const st(c.stats());
+
+          return st.count && (SQLITE_OK == st.result) &&
+            (st.frames_checkpointed == st.wal_frames);
+        }
+      ));
+
+      // a wal is a header and frames, each a header and a page
+      auto const st(c.stats());
+
+      CHECK(st.wal_bytes == (st.wal_frames > 0 ?
+        32 + st.wal_frames * (24 + page) : 0));
+
+      // the writer's autocheckpoint is off, a truncate empties the wal
+      CHECK(SQLITE_OK == squ::execmulti(db, std::string(
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n "
+        "WHERE i < 500) INSERT INTO t SELECT zeroblob(3000) FROM n")));
+      CHECK(c.wal_frames() >= cfg.truncate);
+
+      CHECK(eventually([&]() noexcept
+        {
+          auto const st(c.stats());
+
+          return (SQLITE_CHECKPOINT_TRUNCATE == st.mode) &&
+            (SQLITE_OK == st.result) && !st.wal_frames;
+        }
+      ));
+
+      // checkpoints may be requested whatever the wal size
+      auto const n(c.stats().count);
+
+      c.request();
+
+      CHECK(eventually([&]() noexcept { return c.stats().count > n; }));
+
+      squ::checkpointer::detach(db);
+  }
+
+  CHECK(1001 == squ::execget<int>(db, "SELECT count(*) FROM t").value());
+  }
+
+  for (auto const s: {"", "-wal", "-shm"})
+  {
+    std::remove((std::string("checkpointer.db") + s).c_str());
+  }
+
+  return 0;
+}
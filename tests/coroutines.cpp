@@ -0,0 +1,196 @@
+#include <thread>
+
+#include "test.hpp"
+
+#if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+namespace
+{
+
+// an event loop resuming coroutines on the thread running it
+struct loop
+{
+  std::mutex m;
+  std::condition_variable cv;
+
+  std::deque<std::coroutine_handle<>> q;
+
+  void operator()(std::coroutine_handle<> const h)
+  {
+    {
+      std::lock_guard<std::mutex> l(m);
+
+      q.push_back(h);
+    }
+
+    cv.notify_one();
+  }
+
+  template <typename T>
+  void run(T const& t)
+  {
+    while (!t.done())
+    {
+      std::unique_lock<std::mutex> l(m);
+
+      cv.wait(l, [&]() noexcept { return !q.empty(); });
+
+      auto const h(q.front());
+      q.pop_front();
+
+      l.unlock();
+
+      h.resume();
+    }
+  }
+};
+
+squ::task<int> insert(squ::offloader& o, loop& l, sqlite3_stmt* const s,
+  int const n)
+{
+  for (int i{}; i != n; ++i)
+  {
+    if (auto const r(co_await squ::async_exec(o, l, s, i)); SQLITE_DONE != r)
+    {
+      co_return r;
+    }
+
+    sqlite3_reset(s);
+  }
+
+  co_return SQLITE_DONE;
+}
+
+squ::task<std::thread::id> where(squ::offloader& o, loop& l)
+{
+  co_return co_await squ::offload(o, l, []() noexcept
+    {
+      return std::this_thread::get_id();
+    }
+  );
+}
+
+squ::task<> busy(squ::offloader& o, loop& l, std::atomic<int>& in, int& max)
+{
+  for (int i{}; i != 4; ++i)
+  {
+    co_await squ::offload(o, l, [&]()
+      {
+        max = std::max(max, ++in);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        --in;
+      }
+    );
+  }
+}
+
+}
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a INTEGER PRIMARY KEY)"));
+
+  loop l;
+
+  // exec and execget run on the offloader's thread, one after the other
+  {
+    squ::offloader o(db);
+
+    auto const s(squ::make_unique(db, "INSERT INTO t VALUES(?)"));
+
+    auto t(insert(o, l, s.get(), 100));
+    t.start();
+    l.run(t);
+
+    CHECK(SQLITE_DONE == t.result());
+
+    auto const c(squ::make_unique(db, "SELECT count(*) FROM t"));
+
+    auto g(squ::async_execget<int>(o, l, c));
+    g.start();
+    l.run(g);
+
+    CHECK(100 == g.result().value());
+
+    auto a(where(o, l)), b(where(o, l));
+    a.start();
+    b.start();
+    l.run(a);
+    l.run(b);
+
+    CHECK(std::this_thread::get_id() != a.result());
+    CHECK(a.result() == b.result());
+  }
+
+  // offloaded jobs of several coroutines never overlap
+  {
+    squ::offloader o(db);
+
+    std::atomic<int> in{};
+    int max{};
+
+    auto a(busy(o, l, in, max)), b(busy(o, l, in, max));
+    a.start();
+    b.start();
+    l.run(a);
+    l.run(b);
+
+    CHECK(1 == max);
+  }
+
+  // calls on the connection from other threads wait for a job in flight
+  if (sqlite3_db_mutex(db.get()))
+  {
+    squ::offloader o(db);
+
+    std::atomic<bool> started{}, finished{};
+
+    // the lambda must outlive the coroutine
+    auto const f([&]() -> squ::task<>
+      {
+        co_await squ::offload(o, l, [&]()
+          {
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            finished = true;
+          }
+        );
+      }
+    );
+
+    auto t(f());
+    t.start();
+
+    while (!started);
+
+    CHECK(100 == squ::execget<int>(db, "SELECT count(*) FROM t").value());
+    CHECK(finished);
+
+    l.run(t);
+  }
+
+  // jobs still queued when the offloader goes are run
+  {
+    std::optional<squ::task<std::thread::id>> t;
+
+    {
+      squ::offloader o(db);
+
+      t.emplace(where(o, l));
+      t->start();
+    }
+
+    l.run(*t);
+
+    CHECK(std::this_thread::get_id() != t->result());
+  }
+
+  return 0;
+}
+#else
+int main()
+{
+  return 0;
+}
+#endif // __cpp_impl_coroutine && __cpp_lib_coroutine
@@ -0,0 +1,73 @@
+#include "test.hpp"
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string(
+    "CREATE TABLE t(a INTEGER PRIMARY KEY, b TEXT);"
+    "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n "
+    "WHERE i < 25) INSERT INTO t SELECT i, 'row' || i FROM n"));
+
+  // pages continue after the last key, no transaction stays open between
+  // them, and the last page is the short one
+  {
+    squ::cursor<sqlite3_int64> c(db,
+      "SELECT a, b FROM t WHERE a > ? ORDER BY a LIMIT ?", 0);
+    CHECK(c);
+
+    std::vector<std::pair<int, std::string>> v;
+    std::vector<std::size_t> sizes;
+
+    while (!c.done())
+    {
+      CHECK(SQLITE_DONE == c.page(v, 10));
+      CHECK(sqlite3_get_autocommit(db.get()));
+
+      sizes.push_back(v.size());
+
+      // a write between pages is seen by the next one
+      if (10 == v.size())
+      {
+        squ::execmulti(db, std::string("INSERT INTO t VALUES(26, 'row26')"));
+      }
+    }
+
+    CHECK((std::vector<std::size_t>{10, 20, 26} == sizes));
+    CHECK(26 == c.last());
+
+    for (std::size_t i{}; i != v.size(); ++i)
+    {
+      CHECK(int(i + 1) == v[i].first);
+      CHECK("row" + std::to_string(i + 1) == v[i].second);
+    }
+
+    // an exact multiple ends with an empty page
+    c.seek(16);
+
+    v.clear();
+
+    CHECK(SQLITE_DONE == c.page(v, 5));
+    CHECK(!c.done() && (5 == v.size()));
+    CHECK(SQLITE_DONE == c.page(v, 5));
+    CHECK(!c.done() && (10 == v.size()));
+    CHECK(SQLITE_DONE == c.page(v, 5));
+    CHECK(c.done() && (10 == v.size()));
+    CHECK(26 == c.last());
+  }
+
+  // keys may be text, in another column than the one decoded from
+  {
+    squ::cursor<std::string> c(db,
+      "SELECT a, b FROM t WHERE b > ? ORDER BY b LIMIT ?", "", 1);
+
+    std::vector<int> v;
+
+    CHECK(SQLITE_DONE == c.page(v, 3));
+    CHECK(SQLITE_DONE == c.page(v, 3));
+    CHECK((std::vector<int>{1, 10, 11, 12, 13, 14} == v));
+    CHECK("row14" == c.last());
+  }
+
+  return 0;
+}
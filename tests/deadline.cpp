@@ -0,0 +1,114 @@
+#include "test.hpp"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+// runs for minutes unless interrupted
+constexpr auto forever(
+  "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) "
+  "SELECT max(x) FROM c");
+
+constexpr auto brief(
+  "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c "
+  "WHERE x < 1000) SELECT max(x) FROM c");
+
+}
+
+int main()
+{
+  auto const db(open_memory());
+
+  // an interrupted execget comes back empty, the error code tells why
+  {
+    squ::deadline_guard const g(db, 20ms);
+
+    CHECK(!squ::execget<int>(db, forever));
+    CHECK(SQLITE_INTERRUPT == sqlite3_errcode(db.get()));
+    CHECK(g.expired());
+    CHECK(squ::INTERRUPT_DEADLINE == g.result(SQLITE_INTERRUPT));
+    CHECK(SQLITE_DONE == g.result(SQLITE_DONE));
+  }
+
+  CHECK(1000 == squ::execget<int>(db, brief).value());
+
+  // per call, a passed deadline is told apart from other interruptions
+  {
+    auto const s(squ::make_unique(db, forever));
+
+    auto const r(squ::with_deadline(db, 20ms, [&]() noexcept
+      {
+        return squ::foreach_row(s, [](int) noexcept { return false; });
+      }
+    ));
+
+    CHECK(squ::INTERRUPT_DEADLINE == r);
+    CHECK(SQLITE_INTERRUPT == (r & 0xff));
+    CHECK(std::string("interrupted") == sqlite3_errstr(r));
+
+    sqlite3_reset(s.get());
+  }
+
+  // a cancelled token is not a deadline
+  {
+    squ::cancel_token t;
+    t.cancel();
+
+    squ::deadline_guard const g(db, t, 1);
+
+    CHECK(!squ::execget<int>(db, brief));
+    CHECK(!g.expired());
+    CHECK(SQLITE_INTERRUPT == g.result(SQLITE_INTERRUPT));
+  }
+
+  // an inner guard keeps the deadline of the outer one and puts its handler
+  // back
+  {
+    squ::deadline_guard const o(db, 20ms);
+
+    {
+      squ::cancel_token t;
+      squ::deadline_guard const g(db, t);
+
+      CHECK(!squ::execget<int>(db, forever));
+      CHECK(g.expired());
+    }
+
+    CHECK(!squ::execget<int>(db, forever));
+    CHECK(o.expired());
+
+    // and a guard without either does not touch the handler
+    squ::deadline_guard const n(db,
+      std::chrono::steady_clock::time_point::max());
+
+    CHECK(!squ::execget<int>(db, brief));
+  }
+
+  CHECK(1000 == squ::execget<int>(db, brief).value());
+
+  // guards of different connections interleave on a thread
+  {
+    auto const db2(open_memory());
+
+    squ::deadline_guard const a(db, 20ms);
+
+    {
+      squ::cancel_token t;
+
+      squ::deadline_guard const b(db2, t);
+      squ::deadline_guard const c(db, t);
+
+      CHECK(!squ::execget<int>(db, forever));
+      CHECK(c.expired());
+      CHECK(1000 == squ::execget<int>(db2, brief).value());
+    }
+
+    CHECK(1000 == squ::execget<int>(db2, brief).value());
+    CHECK(!squ::execget<int>(db, forever));
+  }
+
+  CHECK(1000 == squ::execget<int>(db, brief).value());
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+#define SQU_CHECK_PLANS
+
+#include "test.hpp"
+
+namespace
+{
+
+int reported;
+
+}
+
+int main()
+{
+  squ::plan_reporter = [](sqlite3_stmt*, int const p) noexcept
+    {
+      reported |= p;
+    };
+
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(id INTEGER PRIMARY KEY, a, b);"
+    "CREATE INDEX ta ON t(a)"));
+
+  // statements are checked as they are prepared
+  auto const s(squ::make_unique(db, "SELECT * FROM t WHERE a = ? AND id IN "
+    "(SELECT id FROM t WHERE b > 3) ORDER BY b"));
+
+  CHECK((squ::FULL_SCAN | squ::TEMP_BTREE) == reported);
+  CHECK(reported == squ::check_plan(s));
+
+  // the tree has its parents first, children are indices into it
+  auto const p(squ::explain(s));
+  CHECK(!p.empty());
+
+  std::size_t roots{}, children{};
+
+  for (std::size_t i{}; i != p.size(); ++i)
+  {
+    roots += !p[i].parent;
+
+    for (auto const c: p[i].children)
+    {
+      CHECK(c > i);
+      CHECK(p[c].parent == p[i].id);
+
+      ++children;
+    }
+  }
+
+  CHECK(p.size() == roots + children);
+  CHECK(std::any_of(p.begin(), p.end(), [](auto& n)
+    {
+      return !n.detail.compare(0, 6, "SEARCH");
+    }
+  ));
+
+  reported = 0;
+
+  // lookups by key, constant rows and explains themselves are fine
+  for (auto const sql: {"SELECT b FROM t WHERE id = ?", "SELECT 1",
+    "EXPLAIN SELECT * FROM t"})
+  {
+    auto const q(squ::make_shared(db, sql));
+
+    CHECK(!squ::check_plan(q));
+  }
+
+  CHECK(!reported);
+
+  // statements without sql have no plan
+  CHECK(squ::explain(squ::unique_stmt_t()).empty());
+
+#if defined(SQLITE_ENABLE_STMT_SCANSTATUS)
+  squ::execmulti(db, std::string(
+    "INSERT INTO t VALUES(1, 1, 1), (2, 1, 5), (3, 2, 5)"));
+
+  CHECK(SQLITE_DONE == squ::foreach_row(s, [](int) noexcept {}, 1));
+
+  auto const ss(squ::scanstatus(s));
+  CHECK(!ss.empty());
+  CHECK(std::any_of(ss.begin(), ss.end(), [](auto& l)
+    {
+      return l.loops && l.visited && ("t" == l.name);
+    }
+  ));
+
+  squ::scanstatus_reset(s);
+
+  for (auto& l: squ::scanstatus(s))
+  {
+    CHECK(!l.loops && !l.visited);
+  }
+#endif // SQLITE_ENABLE_STMT_SCANSTATUS
+
+  return 0;
+}
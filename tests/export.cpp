@@ -0,0 +1,111 @@
+#include "test.hpp"
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a, b, c, \"we\"\"ird\");"
+    "INSERT INTO t VALUES(1, 2.5, 'plain', NULL),"
+    "(-9223372036854775807, 1e300, 'has,comma \"q\" and\nnl', x'00ff10'),"
+    "(3, 0.1, 'tab\there \\ back', 9e999)"));
+
+  auto const s(squ::make_unique(db, "SELECT * FROM t"));
+
+  std::string out;
+
+  auto const sink([&](char const* const p, std::size_t const n)
+    {
+      out.append(p, n);
+      return true;
+    }
+  );
+
+  squ::export_options o;
+  o.buffer = 8;
+  o.separator = ';';
+
+  CHECK(SQLITE_DONE == squ::export_csv(s, sink, o));
+  CHECK(out ==
+    "a;b;c;\"we\"\"ird\"\n"
+    "1;2.5;plain;\n"
+    "-9223372036854775807;1e+300;\"has,comma \"\"q\"\" and\nnl\";00ff10\n"
+    "3;0.1;tab\there \\ back;inf\n");
+
+  out.clear();
+  squ::reset(s);
+
+  // non-finite reals are null in json, blobs are hex strings
+  CHECK(SQLITE_DONE == squ::export_ndjson(s, sink));
+  CHECK(out ==
+    "{\"a\":1,\"b\":2.5,\"c\":\"plain\",\"we\\\"ird\":null}\n"
+    "{\"a\":-9223372036854775807,\"b\":1e+300,"
+      "\"c\":\"has,comma \\\"q\\\" and\\nnl\",\"we\\\"ird\":\"00ff10\"}\n"
+    "{\"a\":3,\"b\":0.1,\"c\":\"tab\\there \\\\ back\",\"we\\\"ird\":null}\n");
+
+  // the sink sees writes of about the buffer size, refusing one stops the
+  // export
+  {
+    auto const l(squ::make_unique(db, "WITH RECURSIVE c(x) AS (SELECT 1 "
+      "UNION ALL SELECT x + 1 FROM c WHERE x < 1000) SELECT x FROM c"));
+
+    int n{};
+
+    CHECK(SQLITE_IOERR == squ::export_csv(l,
+      [&](char const*, std::size_t const m) noexcept
+      {
+        CHECK(m <= 1024);
+
+        return ++n < 2;
+      },
+      squ::export_options{1024}
+    ));
+    CHECK(2 == n);
+
+    squ::reset(l);
+
+    std::size_t m{};
+
+    CHECK(SQLITE_DONE == squ::export_csv(l,
+      [&](char const*, std::size_t const k) noexcept { m += k; return true; },
+      squ::export_options{1024}
+    ));
+    CHECK(2 + 9 * 2 + 90 * 3 + 900 * 4 + 5 == m);
+  }
+
+  // no header, and an empty result writes nothing
+  {
+    o.header = false;
+
+    out.clear();
+
+    auto const e(squ::make_unique(db, "SELECT * FROM t WHERE 0"));
+
+    CHECK(SQLITE_DONE == squ::export_csv(e, sink, o));
+    CHECK(out.empty());
+  }
+
+  // to a file
+  {
+    std::remove("export.csv");
+
+    auto const f(std::fopen("export.csv", "wb"));
+    CHECK(f);
+
+    CHECK(SQLITE_DONE == squ::export_csv(s, f));
+    std::fclose(f);
+
+    auto const g(std::fopen("export.csv", "rb"));
+    CHECK(g);
+
+    char buf[256];
+    auto const m(std::fread(buf, 1, sizeof(buf), g));
+    std::fclose(g);
+
+    CHECK(std::string_view(buf, m).substr(0, 30) ==
+      "a,b,c,\"we\"\"ird\"\n1,2.5,plain,\n-");
+
+    std::remove("export.csv");
+  }
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include "test.hpp"
+
+namespace
+{
+
+void write(char const* const path, std::string const& s)
+{
+  auto const f(std::fopen(path, "wb"));
+  CHECK(f);
+
+  CHECK(s.size() == std::fwrite(s.data(), 1, s.size(), f));
+  std::fclose(f);
+}
+
+}
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(id, name, score, note);"
+    "CREATE TABLE d(a, b)"));
+
+  // quoting, embedded newlines, blank lines, short and long records, a read
+  // size splitting fields, and batches and transactions of a few rows
+  write("import_csv.csv", "id,name,score,note\r\n"
+    "1,alice,1.5,\"quoted, with comma\"\n"
+    "2,bob,x,\"multi\nline \"\"q\"\"\"\n"
+    "\n"
+    "3,,7,\n"
+    "4,carol\n"
+    "5,dan,2,extra,fields\n"
+    "6,eve,9e2,last");
+
+  {
+    squ::import_options o;
+    o.types = {squ::AS_INTEGER, squ::AS_TEXT, squ::AS_NUMERIC};
+    o.empty_is_null = true;
+    o.batch_rows = 2;
+    o.commit_rows = 3;
+    o.read_size = 7;
+
+    auto const r(squ::import_csv(db, "t", "import_csv.csv", o));
+
+    CHECK(SQLITE_DONE == r.result);
+    CHECK(6 == r.rows);
+  }
+
+  std::string out;
+
+  auto const s(squ::make_unique(db, "SELECT typeof(id) || ':' || id || ' ' || "
+    "quote(name) || ' ' || quote(score) || ' ' || quote(note) FROM t "
+    "ORDER BY rowid"));
+
+  CHECK(SQLITE_DONE == squ::foreach_row(s, [&](std::string_view const v)
+    {
+      out.append(v).push_back('|');
+    }
+  ));
+
+  CHECK(out ==
+    "integer:1 'alice' 1.5 'quoted, with comma'|"
+    "integer:2 'bob' 'x' 'multi\nline \"q\"'|"
+    "integer:3 NULL 7 NULL|"
+    "integer:4 'carol' NULL NULL|"
+    "integer:5 'dan' 2 'extra'|"
+    "integer:6 'eve' 900.0 'last'|");
+
+  // the last, partial transaction is committed too
+  CHECK(sqlite3_get_autocommit(db.get()));
+
+  // every depth, including the inline parser, imports every batch once
+  {
+    std::string csv("a,b\n");
+
+    for (int i{}; i != 100; ++i)
+    {
+      csv.append(std::to_string(i)).append(",x").append(std::to_string(i))
+        .push_back('\n');
+    }
+
+    write("import_csv.csv", csv);
+  }
+
+  for (std::size_t const depth: {0, 1, 4})
+  {
+    squ::import_options o;
+    o.batch_rows = 10;
+    o.depth = depth;
+
+    auto const r(squ::import_csv(db, "d", "import_csv.csv", o));
+
+    CHECK(SQLITE_DONE == r.result);
+    CHECK(100 == r.rows);
+
+    CHECK(4950 == squ::execget<int>(db, "SELECT sum(a) FROM d").value());
+    CHECK(100 == squ::execget<int>(db,
+      "SELECT count(DISTINCT b) FROM d").value());
+
+    squ::execmulti(db, std::string("DELETE FROM d"));
+  }
+
+  // without a header the first record is a row, with another separator
+  write("import_csv.csv", "1;2\n3;4\n");
+
+  {
+    squ::import_options o;
+    o.header = false;
+    o.separator = ';';
+    o.types = {squ::AS_INTEGER, squ::AS_REAL};
+
+    auto const r(squ::import_csv(db, "d", "import_csv.csv", o));
+
+    CHECK(SQLITE_DONE == r.result);
+    CHECK(2 == r.rows);
+    CHECK("integer real" == squ::execget<std::string>(db,
+      "SELECT typeof(a) || ' ' || typeof(b) FROM d WHERE a = 3").value());
+  }
+
+  // a missing table fails before anything is read, a missing file too
+  {
+    auto const r(squ::import_csv(db, "nosuch", "import_csv.csv"));
+
+    CHECK(SQLITE_ERROR == r.result);
+    CHECK(!r.rows);
+  }
+
+  std::remove("import_csv.csv");
+
+  {
+    auto const r(squ::import_csv(db, "d", "import_csv.csv"));
+
+    CHECK(SQLITE_CANTOPEN == r.result);
+    CHECK(!r.rows);
+  }
+
+  CHECK(2 == squ::execget<int>(db, "SELECT count(*) FROM d").value());
+
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include <thread>
+
+#include "test.hpp"
+
+namespace
+{
+
+struct status_tag;
+struct other_tag;
+struct a_tag;
+struct b_tag;
+
+squ::string_pool names;
+
+using status = squ::interned<status_tag>;
+
+}
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a INTEGER, b TEXT);"
+    "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n "
+    "WHERE i < 10000) INSERT INTO t SELECT i, CASE i % 4 WHEN 0 THEN 'ACTIVE' "
+    "WHEN 1 THEN 'DONE' WHEN 2 THEN '' ELSE NULL END FROM n"));
+
+  auto const s(squ::make_unique(db, "SELECT a, b FROM t ORDER BY a"));
+
+  // equal strings share one copy and id, NULL is not the empty string
+  std::vector<std::pair<int, status>> v;
+
+  CHECK(SQLITE_DONE == squ::emplace_back(s, v));
+  CHECK(10000 == v.size());
+  CHECK(3 == status::pool.size());
+
+  CHECK(("DONE" == v[0].second.view) && (status::null_id != v[0].second.id));
+  CHECK(v[0].second.id != v[1].second.id);
+  CHECK(v[1].second.view.empty() && (status::null_id != v[1].second.id));
+  CHECK(v[2].second.view.empty() && (status::null_id == v[2].second.id));
+  CHECK(v[3].second != v[0].second);
+  CHECK(v[4].second == v[0].second);
+  CHECK(v[4].second.view.data() == v[0].second.view.data());
+  CHECK(status::pool.view(v[3].second.id) == "ACTIVE");
+
+  // every tag has its own pool
+  CHECK(!squ::interned<other_tag>::pool.size());
+
+  auto const x(squ::execget<squ::interned<other_tag>>(db, "SELECT 'x'"));
+
+  CHECK("x" == x.value().view);
+  CHECK(1 == squ::interned<other_tag>::pool.size());
+  CHECK(3 == status::pool.size());
+
+  // views stay valid while the pool grows, from any number of threads
+  {
+    std::vector<std::thread> t;
+
+    std::atomic<int> bad{};
+
+    for (int i{}; i != 4; ++i)
+    {
+      t.emplace_back([&, i]()
+        {
+          for (int j{}; j != 2000; ++j)
+          {
+            auto const k(std::to_string((j * 7 + i) % 1000));
+            auto const [sv, id](status::pool.intern(k));
+
+            bad += (sv != k) || (status::pool.view(id) != k);
+          }
+        }
+      );
+    }
+
+    for (auto& h: t)
+    {
+      h.join();
+    }
+
+    CHECK(!bad);
+    CHECK(3 + 1000 == status::pool.size());
+    CHECK("DONE" == v[0].second.view);
+  }
+
+  // a pool may be shared by several tags, and cleared once its strings are
+  // no longer in use
+  {
+    using a = squ::interned<a_tag, names>;
+    using b = squ::interned<b_tag, names>;
+
+    auto const x(squ::execget<a>(db, "SELECT 'n'").value());
+    auto const y(squ::execget<b>(db, "SELECT 'n'").value());
+
+    CHECK((&a::pool == &names) && (&b::pool == &names));
+    CHECK((x.id == y.id) && (1 == names.size()));
+
+    names.clear();
+    CHECK(!names.size());
+    CHECK("m" == squ::execget<a>(db, "SELECT 'm'").value().view);
+    CHECK(1 == names.size());
+  }
+
+  // an interned text column fits a typed statement
+  CHECK((squ::typed_stmt<std::pair<int, status>>(db, "SELECT a, b FROM t")));
+
+  return 0;
+}
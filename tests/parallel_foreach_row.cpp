@@ -0,0 +1,101 @@
+#include "test.hpp"
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a INTEGER, b TEXT);"
+    "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n "
+    "WHERE i < 10000) INSERT INTO t SELECT i, 'row' || i FROM n"));
+
+  auto const s(squ::make_unique(db, "SELECT a, b FROM t ORDER BY a"));
+
+  // every row is passed once, whatever the thread and chunk counts, zero
+  // threads and rows included
+  for (auto const& [threads, rows]: {std::pair<unsigned, std::size_t>{4, 256},
+    {1, 1}, {3, 7}, {0, 0}, {8, 100000}})
+  {
+    std::atomic<long long> sum{};
+    std::atomic<int> bad{};
+
+    CHECK(SQLITE_DONE == squ::parallel_foreach_row(s,
+      [&](int const a, std::string_view const b) noexcept
+      {
+        sum += a;
+        bad += "row" + std::to_string(a) != b;
+      },
+      threads,
+      rows
+    ));
+
+    CHECK(10000LL * 10001 / 2 == sum);
+    CHECK(!bad);
+
+    squ::reset(s);
+  }
+
+  // results are folded in row order on the calling thread
+  {
+    auto const r(squ::parallel_foreach_row(s,
+      [](int const a, std::string_view) { return std::to_string(a); },
+      3,
+      std::string(),
+      [](std::string a, std::string const& v)
+      {
+        if (a.size() < 20)
+        {
+          a.append(v).push_back(',');
+        }
+
+        return a;
+      },
+      7
+    ));
+
+    CHECK(SQLITE_DONE == r.first);
+    CHECK("1,2,3,4,5,6,7,8,9,10," == r.second);
+
+    squ::reset(s);
+  }
+
+  {
+    auto const r(squ::parallel_foreach_row(s.get(),
+      [](long long const a) noexcept { return a; },
+      8u,
+      0ll,
+      [](long long const a, long long const b) noexcept { return a + b; },
+      0
+    ));
+
+    CHECK(SQLITE_DONE == r.first);
+    CHECK(10000LL * 10001 / 2 == r.second);
+
+    squ::reset(s);
+  }
+
+  // also predicates
+  {
+    auto const r(squ::parallel_foreach_row(s,
+      [](int const a) noexcept { return a > 0; },
+      4,
+      true,
+      [](bool const a, bool const b) noexcept { return a && b; },
+      64
+    ));
+
+    CHECK(SQLITE_DONE == r.first);
+    CHECK(r.second);
+
+    squ::reset(s);
+  }
+
+  // an empty result calls nothing
+  {
+    auto const e(squ::make_unique(db, "SELECT a FROM t WHERE 0"));
+
+    CHECK(SQLITE_DONE == squ::parallel_foreach_row(e,
+      [](int) noexcept { CHECK(false); }, 2));
+  }
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "test.hpp"
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a INTEGER, b TEXT, c BLOB);"
+    "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n "
+    "WHERE i < 10000) INSERT INTO t SELECT i, 'row' || i, zeroblob(i % 7) "
+    "FROM n"));
+
+  auto const s(squ::make_unique(db, "SELECT a, b, c FROM t ORDER BY a"));
+
+  // rows come in order, text and blobs copied, for any batch size and depth
+  for (auto const& [depth, rows]: {std::pair<std::size_t, std::size_t>{2, 256},
+    {1, 1}, {4, 7}, {1, 0}, {3, 100000}})
+  {
+    int n{};
+
+    {
+      auto p(squ::prefetch_rows<int, std::string_view, squ::blobpair<>>(s,
+        depth, rows));
+
+      for (auto& [a, b, c]: p)
+      {
+        CHECK(++n == a);
+        CHECK(("row" + std::to_string(a)) == b);
+        CHECK(std::size_t(a % 7) == c.second);
+      }
+
+      CHECK(SQLITE_DONE == p.result());
+    }
+
+    CHECK(10000 == n);
+
+    squ::reset(s);
+  }
+
+  // leaving early stops the background thread
+  {
+    auto p(squ::prefetch_rows<int, char const*>(s, 1, 16));
+
+    int k{};
+
+    for (auto& r: p)
+    {
+      if (++k == 3)
+      {
+        CHECK(std::string("row3") == std::get<1>(r));
+
+        break;
+      }
+    }
+  }
+
+  squ::reset(s);
+
+  // rows may be pairs and tuples, and results may be empty
+  {
+    std::size_t k{};
+
+    for (auto& [r]: squ::prefetch_rows<std::pair<int, std::u16string_view>>(
+      s.get(), 1, 7))
+    {
+      k += r.second.size();
+    }
+
+    // "row" and the digits of 1 to 10000
+    CHECK(3 * 10000 + 9 + 2 * 90 + 3 * 900 + 4 * 9000 + 5 == k);
+
+    auto const e(squ::make_unique(db, "SELECT a FROM t WHERE 0"));
+
+    auto p(squ::prefetch_rows<int>(e));
+    CHECK(p.begin() == p.end());
+    CHECK(SQLITE_DONE == p.result());
+  }
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+#include <cmath>
+
+#include <thread>
+
+#include "test.hpp"
+
+namespace
+{
+
+// connections replay concurrently, so rows can be inserted in another order
+constexpr auto digest(
+  "SELECT group_concat(r, ';') FROM (SELECT quote(a) || ',' || quote(b) || "
+  "',' || quote(c) r FROM t ORDER BY r)");
+
+}
+
+int main()
+{
+  std::remove("recorder.db");
+  std::remove("recorder_copy.db");
+
+  auto const flags(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+
+  auto const a(squ::open_unique("recorder.db", flags));
+  auto const b(squ::open_unique("recorder.db", flags));
+
+  squ::execmulti(a, std::string("CREATE TABLE t(a, b, c);"
+    "VACUUM INTO 'recorder_copy.db'"));
+
+  {
+    squ::recorder r("recorder.log");
+    CHECK(r);
+
+    CHECK(SQLITE_OK == r.attach(a));
+    CHECK(SQLITE_OK == r.attach(b));
+
+    // the trace callback is shared with the other components
+    squ::change_stream cs(16);
+    cs.attach(a);
+
+    // a transaction of a is interleaved with statements of b, so replaying
+    // them on one connection, or dealing them out in turn, goes wrong
+    CHECK(SQLITE_DONE == squ::exec(a, "BEGIN"));
+    CHECK(SQLITE_DONE == squ::exec(a, "INSERT INTO t VALUES(?, ?, ?)",
+      1, 0.25, "it's"));
+    CHECK(0 == squ::execget<int>(b, "SELECT count(*) FROM t").value());
+    CHECK(SQLITE_DONE == squ::exec(a, "INSERT INTO t VALUES(?, ?, ?)",
+      -(sqlite3_int64(1) << 62), 1e300, nullptr));
+    CHECK(SQLITE_DONE == squ::exec(a, "COMMIT"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // named and numbered parameters, some used twice, blobs and doubles
+    // sqlite writes out specially
+    {
+      auto const s(squ::make_unique(b,
+        "INSERT INTO t VALUES(:x, ?3, @y || ?3), (?2, $z::w, :x)"));
+
+      CHECK(SQLITE_OK == sqlite3_bind_text(s.get(), 1, "':x'", -1,
+        SQLITE_STATIC));
+      CHECK(SQLITE_OK == sqlite3_bind_double(s.get(), 2, HUGE_VAL));
+      CHECK(SQLITE_OK == sqlite3_bind_int(s.get(), 3, 3));
+      CHECK(SQLITE_OK == sqlite3_bind_text(s.get(), 4, "y", -1,
+        SQLITE_STATIC));
+      CHECK(SQLITE_OK == sqlite3_bind_blob(s.get(), 5, "\0\xff", 2,
+        SQLITE_STATIC));
+      CHECK(SQLITE_DONE == sqlite3_step(s.get()));
+    }
+
+    CHECK(SQLITE_DONE == squ::exec(b, "INSERT INTO t VALUES(?, ?, ?)",
+      -HUGE_VAL, -0.5, squ::blobpair<squ::STATIC>{nullptr, 3}));
+
+    // a statement that fails is replayed and fails again
+    CHECK(SQLITE_ERROR == squ::exec(b, "SELECT abs(?)",
+      std::numeric_limits<sqlite3_int64>::min()));
+
+    CHECK(2 == cs.drain([](squ::change&&) noexcept {}));
+    cs.detach(a);
+
+    CHECK(SQLITE_OK == r.detach(a));
+    CHECK(SQLITE_OK == r.detach(b));
+
+    // detached connections are not recorded
+    CHECK(SQLITE_DONE == squ::exec(a, "INSERT INTO t VALUES(?, 0, 0)",
+      "unrecorded"));
+  }
+
+  {
+    auto const r(squ::replay("recorder.log", "recorder_copy.db"));
+
+    CHECK(SQLITE_OK == r.result);
+    CHECK(2 == r.connections);
+    CHECK(8 == r.statements);
+    CHECK(1 == r.failures);
+    CHECK(8 == r.latencies.size());
+    CHECK(std::is_sorted(r.latencies.cbegin(), r.latencies.cend()));
+  }
+
+  {
+    auto const c(squ::open_unique("recorder_copy.db", SQLITE_OPEN_READWRITE));
+
+    CHECK(6 == squ::execget<int>(a, "SELECT count(*) FROM t").value());
+    CHECK(5 == squ::execget<int>(c, "SELECT count(*) FROM t").value());
+
+    CHECK(SQLITE_DONE == squ::exec(a, "DELETE FROM t WHERE a = ?",
+      "unrecorded"));
+
+    auto const x(squ::execget<std::string>(a, digest));
+    auto const y(squ::execget<std::string>(c, digest));
+
+    CHECK(x && y && (*x == *y));
+    CHECK(std::string::npos != x->find("'it''s'"));
+    CHECK(std::string::npos != x->find("X'00FF'"));
+    CHECK(std::string::npos != x->find("X'000000'"));
+  }
+
+  // paced replays keep the recorded gaps, scaled by the speed
+  {
+    squ::replay_options o;
+    o.paced = true;
+    o.speed = .5;
+
+    auto const r(squ::replay("recorder.log", "recorder_copy.db", o));
+
+    CHECK(SQLITE_OK == r.result);
+    CHECK(r.elapsed >= std::chrono::milliseconds(90));
+  }
+
+  // copies multiply the recorded connections
+  {
+    auto const c(squ::open_unique("recorder_copy.db", SQLITE_OPEN_READWRITE));
+    auto const n(squ::execget<int>(c, "SELECT count(*) FROM t").value());
+
+    squ::replay_options o;
+    o.copies = 3;
+
+    auto const r(squ::replay("recorder.log", "recorder_copy.db", o));
+
+    CHECK(SQLITE_OK == r.result);
+    CHECK(6 == r.connections);
+    CHECK(24 == r.statements);
+    CHECK(3 == r.failures);
+    CHECK(n + 15 == squ::execget<int>(c, "SELECT count(*) FROM t").value());
+  }
+
+  CHECK(SQLITE_CANTOPEN == squ::replay("recorder.none", "recorder.db").result);
+  CHECK(SQLITE_NOTADB == squ::replay("recorder.db", "recorder.db").result);
+
+  // a truncated log is rejected before anything runs
+  {
+    std::string log;
+
+    {
+      auto const f(std::fopen("recorder.log", "rb"));
+      char buf[1 << 12];
+
+      for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), f));)
+      {
+        log.append(buf, n);
+      }
+
+      std::fclose(f);
+    }
+
+    auto const f(std::fopen("recorder.log", "wb"));
+    std::fwrite(log.data(), 1, log.size() - 1, f);
+    std::fclose(f);
+
+    CHECK(SQLITE_CORRUPT == squ::replay("recorder.log", "recorder.db").result);
+  }
+
+  return 0;
+}
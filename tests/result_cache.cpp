@@ -0,0 +1,229 @@
+#include "test.hpp"
+
+int main()
+{
+  auto const db(open_memory()), db2(open_memory());
+
+  squ::execmulti(db, std::string(
+    "CREATE TABLE t(id INTEGER PRIMARY KEY, v);"
+    "INSERT INTO t VALUES(5, 'five'), (7, 'seven');"
+    "CREATE TABLE u(x); INSERT INTO u VALUES(1), (2), (3);"
+    "CREATE TEMP TABLE x(a); INSERT INTO x VALUES(1)"));
+  squ::execmulti(db2, std::string("CREATE TABLE u(x); INSERT INTO u VALUES(1);"
+    "CREATE TEMP TABLE x(a)"));
+
+  squ::result_cache c;
+  c.attach(db);
+  c.attach(db2);
+
+  // results are keyed by the bound values
+  auto const s(squ::make_unique(db, "SELECT v FROM t WHERE id = ?"));
+
+  CHECK("five" == squ::cached_rexecget<std::string>(c, s, 0, 5).value());
+  CHECK("seven" == squ::cached_rexecget<std::string>(c, s, 0, 7).value());
+  CHECK("five" == squ::cached_rexecget<std::string>(c, s, 0, 5).value());
+  CHECK(!squ::cached_rexecget<std::string>(c, s, 0, 6));
+  CHECK(!squ::cached_rexecget<std::string>(c, s, 0, 6));
+  CHECK(2 == c.hits());
+  CHECK(3 == c.size());
+
+  // values bound beforehand are not part of the key, so are never cached
+  CHECK(SQLITE_OK == squ::rset(s, 5));
+  CHECK("five" == squ::cached_execget<std::string>(c, s).value());
+  CHECK(SQLITE_OK == squ::rset(s, 7));
+  CHECK("seven" == squ::cached_execget<std::string>(c, s).value());
+  CHECK(2 == c.hits());
+
+  // in-memory and temporary databases of different connections differ
+  {
+    auto const a(squ::make_unique(db, "SELECT count(*) FROM u"));
+    auto const b(squ::make_unique(db2, "SELECT count(*) FROM u"));
+
+    CHECK(3 == squ::cached_rexecget<int>(c, a).value());
+    CHECK(1 == squ::cached_rexecget<int>(c, b).value());
+
+    auto const ta(squ::make_unique(db, "SELECT count(*) FROM temp.x"));
+    auto const tb(squ::make_unique(db2, "SELECT count(*) FROM temp.x"));
+
+    CHECK(1 == squ::cached_rexecget<int>(c, ta).value());
+    CHECK(0 == squ::cached_rexecget<int>(c, tb).value());
+
+    // any commit invalidates, deletes and schema changes included
+    squ::execmulti(db, std::string("DELETE FROM u"));
+    CHECK(0 == squ::cached_rexecget<int>(c, a).value());
+    CHECK(1 == squ::cached_rexecget<int>(c, b).value());
+
+    auto const m(squ::make_unique(db, "SELECT count(*) FROM sqlite_schema"));
+
+    CHECK(2 == squ::cached_rexecget<int>(c, m).value());
+    squ::execmulti(db, std::string("CREATE TABLE z(a)"));
+    CHECK(3 == squ::cached_rexecget<int>(c, m).value());
+
+    // nothing is cached inside a transaction, whose snapshot is its own
+    squ::execmulti(db, std::string("BEGIN; INSERT INTO u VALUES(9)"));
+
+    auto const h(c.hits());
+
+    CHECK(1 == squ::cached_rexecget<int>(c, a).value());
+    CHECK(1 == squ::cached_rexecget<int>(c, a).value());
+    CHECK(h == c.hits());
+
+    squ::execmulti(db, std::string("ROLLBACK"));
+    CHECK(0 == squ::cached_rexecget<int>(c, a).value());
+  }
+
+  // statements with side effects or reading no table are run every time
+  {
+    auto const w(squ::make_unique(db, "INSERT INTO u VALUES(?) RETURNING x"));
+
+    CHECK(4 == squ::cached_rexecget<int>(c, w, 0, 4).value());
+    CHECK(4 == squ::cached_rexecget<int>(c, w, 0, 4).value());
+    CHECK(2 == squ::execget<int>(db, "SELECT count(*) FROM u").value());
+
+    auto const r(squ::make_unique(db, "SELECT random()"));
+
+    CHECK(squ::cached_rexecget<std::int64_t>(c, r).value() !=
+      squ::cached_rexecget<std::int64_t>(c, r).value());
+
+    // nor are those calling functions whose results vary
+    auto const h(c.hits());
+
+    for (auto const sql: {"SELECT random() FROM u",
+      "SELECT datetime('now') FROM u", "SELECT changes() FROM u"})
+    {
+      auto const v(squ::make_unique(db, sql));
+
+      squ::cached_rexecget<std::string>(c, v);
+      squ::cached_rexecget<std::string>(c, v);
+    }
+
+    CHECK(h == c.hits());
+
+    auto const d(squ::make_unique(db, "SELECT abs(x) FROM u"));
+
+    squ::cached_rexecget<int>(c, d);
+    squ::cached_rexecget<int>(c, d);
+    CHECK(h + 1 == c.hits());
+  }
+
+  // errors are not results
+  {
+    auto const e(squ::make_unique(db, "SELECT abs(?) FROM u"));
+
+    auto const m(c.misses());
+
+    CHECK(!squ::cached_rexecget<std::int64_t>(c, e, 0,
+      std::numeric_limits<std::int64_t>::min()));
+    CHECK(!squ::cached_rexecget<std::int64_t>(c, e, 0,
+      std::numeric_limits<std::int64_t>::min()));
+    CHECK(m + 2 == c.misses());
+  }
+
+  c.detach(db2);
+
+  // changes through a connection that is not attached need invalidate()
+  {
+    auto const b(squ::make_unique(db2, "SELECT count(*) FROM u"));
+
+    CHECK(1 == squ::cached_rexecget<int>(c, b).value());
+    squ::execmulti(db2, std::string("DELETE FROM u"));
+    CHECK(1 == squ::cached_rexecget<int>(c, b).value());
+
+    c.invalidate(db2);
+    CHECK(0 == squ::cached_rexecget<int>(c, b).value());
+  }
+
+  c.detach(db);
+
+  // a file is shared, a commit by one attached connection drops what the
+  // others read from it
+  {
+    std::remove("result_cache.db");
+
+    auto const open([]()
+      {
+        return squ::open_shared("result_cache.db",
+          SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+      }
+    );
+
+    auto const f(open()), g(open());
+
+    squ::execmulti(f, std::string("PRAGMA journal_mode=WAL;"
+      "CREATE TABLE t(a); INSERT INTO t VALUES(1)"));
+
+    c.attach(f);
+    c.attach(g);
+
+    auto const q(squ::make_unique(f, "SELECT count(*) FROM t"));
+    auto const r(squ::make_unique(g, "SELECT count(*) FROM t"));
+
+    CHECK(1 == squ::cached_rexecget<int>(c, q).value());
+    CHECK(1 == squ::cached_rexecget<int>(c, r).value());
+
+    auto const h(c.hits());
+
+    squ::execmulti(g, std::string("INSERT INTO t VALUES(2)"));
+    CHECK(2 == squ::cached_rexecget<int>(c, q).value());
+    CHECK(h == c.hits());
+
+    // a reader running while a commit is in progress sees the old snapshot,
+    // what it stores is dropped once the commit has finished
+    struct reader
+    {
+      squ::result_cache* c;
+      sqlite3_stmt* s;
+      int n;
+    } rd{&c, r.get(), 0};
+
+    squ::detail::hooks::subscribe(f.get(), {&rd, &rd,
+      [](void* const p) noexcept
+      {
+        auto& rd(*static_cast<reader*>(p));
+
+        rd.n = squ::cached_rexecget<int>(*rd.c, rd.s).value();
+
+        return 0;
+      },
+      {}, {}}
+    );
+
+    squ::execmulti(f, std::string("INSERT INTO t VALUES(3)"));
+    squ::detail::hooks::unsubscribe(f.get(), &rd);
+
+    CHECK(2 == rd.n);
+    CHECK(3 == squ::cached_rexecget<int>(c, r).value());
+
+    c.detach(f);
+    c.detach(g);
+  }
+
+  std::remove("result_cache.db");
+
+  // the cache stays within its budget, evicting the least recently used
+  {
+    squ::result_cache b(1024);
+
+    auto const q(squ::make_unique(db, "SELECT v || ? FROM t WHERE id = 5"));
+
+    for (int i{}; i != 1000; ++i)
+    {
+      CHECK("five" + std::to_string(i) == squ::cached_rexecget<std::string>(
+        b, q, 0, std::to_string(i)).value());
+      CHECK(b.bytes() <= 1024);
+    }
+
+    CHECK(b.size() && (b.size() < 1000));
+
+    auto const h(b.hits());
+
+    squ::cached_rexecget<std::string>(b, q, 0, std::to_string(999));
+    squ::cached_rexecget<std::string>(b, q, 0, std::to_string(0));
+    CHECK(h + 1 == b.hits());
+
+    b.clear();
+    CHECK(!b.size() && !b.bytes());
+  }
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include "test.hpp"
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a INTEGER, b TEXT, c BLOB);"
+    "INSERT INTO t VALUES(1, 'x', x'0102'), (2, NULL, NULL), (3, 'zz', x'')"));
+
+  auto const s(squ::make_unique(db, "SELECT a, b, c FROM t ORDER BY a"));
+
+  // columns are looked up by index or name and decoded on access
+  int n{};
+
+  CHECK(SQLITE_DONE == squ::foreach_row(s, [&](squ::row_view const& r)
+    {
+      ++n;
+
+      CHECK(3 == r.size());
+      CHECK(s.get() == r.stmt());
+      CHECK(n == r.get<int>("a"));
+      CHECK(n == r.get<int>(0));
+      CHECK((2 == n) == r.is_null(1));
+      CHECK((2 == n) == r.is_null(r.index("c")));
+      CHECK((2 == n ? SQLITE_NULL : SQLITE_BLOB) == r.type(2));
+      CHECK(-1 == r.index("nope"));
+
+      switch (n)
+      {
+        case 1:
+          CHECK("x" == r.get<std::string_view>(1));
+          CHECK(2 == r.get<squ::blobpair<>>("c").second);
+          break;
+
+        case 2:
+          CHECK(r.get<std::string_view>("b").empty());
+          CHECK(!r.get<char const*>(1));
+          break;
+
+        default:
+          CHECK("zz" == r.get<std::string>("b"));
+          CHECK(!r.get<squ::blobpair<>>(2).second);
+      }
+    }
+  ));
+
+  CHECK(3 == n);
+
+  squ::reset(s);
+
+  // after other arguments it views the columns that follow them, and the
+  // callback may stop early
+  n = 0;
+
+  CHECK(SQLITE_ROW == squ::foreach_row(s,
+    [&](int const a, squ::row_view const& r) noexcept
+    {
+      ++n;
+
+      CHECK(2 == r.size());
+      CHECK(1 == r.index("c"));
+      CHECK(0 == r.index("b"));
+      CHECK(-1 == r.index("a"));
+      CHECK(SQLITE_BLOB == r.type(1) || (2 == a));
+
+      return 2 == a;
+    }
+  ));
+
+  CHECK(2 == n);
+
+  // or it is taken from a stepped statement directly
+  CHECK(SQLITE_ROW == squ::rexec(s));
+
+  auto const r(squ::get<squ::row_view>(s, 1));
+
+  CHECK((2 == r.size()) && ("x" == r.get<std::string_view>(0)));
+
+  return 0;
+}
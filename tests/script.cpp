@@ -0,0 +1,111 @@
+#include "test.hpp"
+
+int main()
+{
+  auto const db(open_memory());
+
+  // statements are prepared as they are run, so a script may create the
+  // schema it then uses
+  {
+    squ::script s(db, "CREATE TABLE t(a INTEGER UNIQUE, b TEXT);"
+      " -- comment\n INSERT INTO t VALUES(1, 'x');"
+      "INSERT INTO t SELECT a + 1, b FROM t; /* trailing */ ");
+
+    CHECK(s);
+    CHECK(!s.size() && !s.complete());
+
+    auto const r(s.exec());
+
+    CHECK(SQLITE_DONE == r.result);
+    CHECK(3 == r.index);
+    CHECK((3 == s.size()) && s.complete());
+    CHECK(3 == squ::execget<int>(db, "SELECT sum(a) FROM t").value());
+  }
+
+  // parameters are bound per statement, the failing statement is reported,
+  // and the script runs again from the start
+  {
+    squ::script s(db, "INSERT INTO t VALUES(?, 'y'); SELECT * FROM t;"
+      "INSERT INTO t VALUES(?, 'z')");
+
+    auto const bind([](int const a, int const b)
+      {
+        return [=](std::size_t const i, sqlite3_stmt* const p) noexcept
+          {
+            return 1 == i ? SQLITE_OK : squ::set(p, i ? b : a);
+          };
+      }
+    );
+
+    CHECK(SQLITE_DONE == s.exec(bind(10, 11)).result);
+    CHECK(SQLITE_DONE == s.exec(bind(20, 21)).result);
+
+    auto const r(s.exec(bind(30, 30)));
+
+    CHECK(SQLITE_CONSTRAINT == r.result);
+    CHECK(2 == r.index);
+
+    // a binder may stop the script
+    auto const q(s.exec([](std::size_t const i, sqlite3_stmt* const p)
+      noexcept
+      {
+        return i ? SQLITE_ABORT : squ::set(p, 40);
+      }
+    ));
+
+    CHECK(SQLITE_ABORT == q.result);
+    CHECK(1 == q.index);
+
+    CHECK(8 == squ::execget<int>(db, "SELECT count(*) FROM t").value());
+
+    // no statement is left holding a transaction open
+    CHECK(sqlite3_get_autocommit(db.get()));
+    CHECK(!sqlite3_stmt_busy(s[1]));
+  }
+
+  // a failed prepare is retried on the next run
+  {
+    squ::script s(db, "INSERT INTO u VALUES(1); SELECT 1");
+
+    auto r(s.exec());
+
+    CHECK(SQLITE_ERROR == r.result);
+    CHECK(0 == r.index);
+    CHECK(!s);
+    CHECK(SQLITE_ERROR == s.prepared().result);
+
+    squ::execmulti(db, std::string("CREATE TABLE u(x)"));
+
+    r = s.exec();
+
+    CHECK(SQLITE_DONE == r.result);
+    CHECK(2 == r.index);
+    CHECK(s && s.complete());
+  }
+
+  // or all statements may be prepared up front
+  {
+    squ::script s(db, "SELECT 1; SELEC 2; SELECT 3");
+
+    auto const r(s.prepare());
+
+    CHECK(SQLITE_ERROR == r.result);
+    CHECK(1 == r.index);
+    CHECK(1 == s.size());
+
+    squ::script t(db, "SELECT 1; SELECT 2");
+
+    CHECK(SQLITE_OK == t.prepare().result);
+    CHECK((2 == t.size()) && t.complete());
+  }
+
+  // nothing to run
+  {
+    squ::script s(db, "  -- nothing\n");
+
+    CHECK(SQLITE_DONE == s.exec().result);
+    CHECK(!s.size() && s.complete());
+  }
+
+  return 0;
+}
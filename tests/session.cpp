@@ -0,0 +1,140 @@
+#include "test.hpp"
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+namespace
+{
+
+constexpr auto schema("CREATE TABLE t(id INTEGER PRIMARY KEY, v)");
+
+auto contents(squ::unique_db_t const& db)
+{
+  return squ::execget<std::string>(db,
+    "SELECT group_concat(id || v, ' ') FROM (SELECT * FROM t ORDER BY id)")
+    .value_or("");
+}
+
+}
+
+int main()
+{
+  auto const a(open_memory()), b(open_memory());
+
+  squ::execmulti(a, std::string(schema));
+  squ::execmulti(b, std::string(schema));
+  squ::execmulti(b, std::string("INSERT INTO t VALUES(2, 'theirs')"));
+
+  auto const s(squ::make_session(a));
+  CHECK(s);
+  CHECK(SQLITE_OK == squ::session_attach(s));
+
+  squ::execmulti(a, std::string("INSERT INTO t VALUES(1, 'a'), (2, 'b'),"
+    "(3, 'c'); UPDATE t SET v = 'z' WHERE id = 3"));
+
+  auto const c(squ::changeset(s));
+  CHECK(c.first && c.second);
+
+  // the default gives up on the first conflict, leaving b as it was
+  CHECK(SQLITE_ABORT == squ::changeset_apply(b, c));
+  CHECK("2theirs" == contents(b));
+
+  // handlers and sinks may be const lvalues
+  int n{};
+
+  auto const omit([&](squ::changeset_conflict const& k)
+    {
+      ++n;
+
+      CHECK(squ::conflict::conflict == k.type);
+      CHECK(("t" == k.table()) && (2 == k.columns()));
+      CHECK(SQLITE_INSERT == k.op());
+      CHECK(2 == std::get<sqlite3_int64>(k.new_value(0).value()));
+      CHECK("b" == std::get<std::string>(k.new_value(1).value()));
+      CHECK("theirs" == std::get<std::string>(k.conflict_value(1).value()));
+      CHECK(!k.old_value(1));
+
+      return squ::resolution::omit;
+    }
+  );
+
+  CHECK(SQLITE_OK == squ::changeset_apply(b, c, omit));
+  CHECK(1 == n);
+  CHECK("1a 2theirs 3z" == contents(b));
+
+  // streamed through a FILE*, and through a sink and a source
+  {
+    auto const f(std::tmpfile());
+    CHECK(f);
+
+    CHECK(SQLITE_OK == squ::changeset_strm(s, f));
+    std::rewind(f);
+
+    auto const d(open_memory());
+    squ::execmulti(d, std::string(schema));
+
+    CHECK(SQLITE_OK == squ::changeset_apply_strm(d, f));
+    CHECK("1a 2b 3z" == contents(d));
+
+    std::fclose(f);
+  }
+
+  {
+    std::string out;
+
+    auto const k([&](char const* const p, std::size_t const m)
+      {
+        out.append(p, m);
+
+        return true;
+      }
+    );
+
+    CHECK(SQLITE_OK == squ::changeset_strm(s, k));
+    CHECK(std::size_t(c.second) == out.size());
+    CHECK(!std::memcmp(c.first.get(), out.data(), out.size()));
+
+    // a source handing out a few bytes at a time
+    std::size_t i{};
+
+    auto const src([&](void* const p, int& m) noexcept
+      {
+        m = int(std::min({std::size_t(m), std::size_t(3), out.size() - i}));
+        std::memcpy(p, out.data() + i, std::size_t(m));
+        i += std::size_t(m);
+
+        return true;
+      }
+    );
+
+    auto const d(open_memory());
+    squ::execmulti(d, std::string(schema));
+
+    CHECK(SQLITE_OK == squ::changeset_apply_strm(d, src));
+    CHECK("1a 2b 3z" == contents(d));
+
+    // a failing sink fails the stream
+    CHECK(SQLITE_OK != squ::changeset_strm(s,
+      [](char const*, std::size_t) noexcept { return false; }));
+  }
+
+  // a patchset carries no old values, so replays over the other change
+  {
+    auto const p(squ::patchset(s));
+    CHECK(p.first && (p.second <= c.second));
+
+    CHECK(SQLITE_OK == squ::changeset_apply(b, p,
+      [](squ::changeset_conflict const&) noexcept
+      {
+        return squ::resolution::replace;
+      }
+    ));
+    CHECK("1a 2b 3z" == contents(b));
+  }
+
+  return 0;
+}
+#else
+int main()
+{
+  return 0;
+}
+#endif // SQLITE_ENABLE_SESSION && SQLITE_ENABLE_PREUPDATE_HOOK
@@ -0,0 +1,171 @@
+#include <tuple>
+
+#include "test.hpp"
+
+int main()
+{
+  std::vector<std::string> files;
+
+  for (int i{}; i != 3; ++i)
+  {
+    files.push_back("sharded_db" + std::to_string(i) + ".db");
+
+    for (auto const s: {"", "-wal", "-shm"})
+    {
+      std::remove((files.back() + s).c_str());
+    }
+  }
+
+  {
+    squ::sharded_db db(files);
+
+    CHECK(db.ok());
+    CHECK(SQLITE_OK == db.result());
+    CHECK(3 == db.size());
+
+    for (auto& f: db.exec_all("CREATE TABLE t(k INTEGER, a, b)"))
+    {
+      CHECK(SQLITE_DONE == f.get());
+    }
+
+    std::vector<std::future<int>> r;
+
+    // views and pointers, whose targets change before the writer binds them
+    {
+      std::string s("text");
+      char buf[]{"char"};
+      std::vector<unsigned char> blob{1, 2, 3};
+      std::u16string u(u"utf16");
+
+      r.push_back(db.exec_on(0, "INSERT INTO t VALUES(?, ?, ?)", 0,
+        std::string_view(s), static_cast<char const*>(buf)));
+      r.push_back(db.exec_on(1, "INSERT INTO t VALUES(?, ?, ?)", 1,
+        squ::blobpair<squ::STATIC>{blob.data(), blob.size()},
+        squ::charpair<squ::STATIC>{s.data(), s.size()}));
+      r.push_back(db.exec_on(2, "INSERT INTO t VALUES(?, ?, ?)", 2,
+        static_cast<char16_t const*>(u.c_str()),
+        squ::blobpair<squ::STATIC>{nullptr, 2}));
+      r.push_back(db.exec_on(0, "INSERT INTO t VALUES(?, ?, ?)", 3,
+        static_cast<char const*>(nullptr), std::u16string_view(u)));
+#if defined(__cpp_lib_span)
+      r.push_back(db.exec_on(1, "INSERT INTO t VALUES(?, ?, ?)", 4,
+        std::span<unsigned char const>(blob), nullptr));
+#else
+      r.push_back(db.exec_on(1, "INSERT INTO t VALUES(?, ?, ?)", 4,
+        squ::blobpair<>{blob.data(), blob.size()}, nullptr));
+#endif // __cpp_lib_span
+
+      s.assign(s.size(), 'x');
+      std::fill(std::begin(buf), std::end(buf) - 1, 'x');
+      blob.assign(blob.size(), 0);
+      u.assign(u.size(), u'x');
+    }
+
+    // a statement with fewer arguments does not see earlier bindings
+    r.push_back(db.exec_on(2, "INSERT INTO t VALUES(?, ?, ?)", 5));
+
+    // writes by key are grouped into transactions
+    for (int k(6); k != 1000; ++k)
+    {
+      r.push_back(db.exec(k, "INSERT INTO t VALUES(?, ?, ?)", k,
+        std::to_string(k), nullptr));
+    }
+
+    for (auto& f: r)
+    {
+      CHECK(SQLITE_DONE == f.get());
+    }
+
+    // a failure is reported for its own statement only
+    CHECK(SQLITE_DONE != db.exec_on(0, "INSERT INTO nope VALUES(1)").get());
+
+    std::vector<std::tuple<int, std::string, std::string>> v;
+
+    CHECK(SQLITE_DONE == db.gather(v, "SELECT k, quote(a), quote(b) FROM t "
+      "WHERE k < ? ORDER BY k", 0, 6));
+    CHECK(6 == v.size());
+
+    std::sort(v.begin(), v.end());
+
+    CHECK(std::make_tuple(0, std::string("'text'"), std::string("'char'")) ==
+      v[0]);
+    CHECK(std::make_tuple(1, std::string("X'010203'"),
+      std::string("'text'")) == v[1]);
+    CHECK(std::make_tuple(2, std::string("'utf16'"),
+      std::string("X'0000'")) == v[2]);
+    CHECK(std::make_tuple(3, std::string("NULL"), std::string("'utf16'")) ==
+      v[3]);
+    CHECK(std::make_tuple(4, std::string("X'010203'"),
+      std::string("NULL")) == v[4]);
+    CHECK(std::make_tuple(5, std::string("NULL"), std::string("NULL")) ==
+      v[5]);
+
+    std::vector<int> n;
+
+    CHECK(SQLITE_DONE == db.gather(n, "SELECT count(*) FROM t"));
+    CHECK(3 == n.size());
+    CHECK(1000 == n[0] + n[1] + n[2]);
+  }
+
+  // a failure that rolls back the whole transaction fails the jobs grouped
+  // before it, those after it are committed in a new one
+  {
+    squ::sharded_db db({files[0]});
+
+    CHECK(SQLITE_DONE ==
+      db.exec_on(0, "CREATE TABLE w(k INTEGER PRIMARY KEY)").get());
+
+    // the writer waits on the lock until all jobs have queued up
+    auto const l(squ::open_shared(files[0], SQLITE_OPEN_READWRITE));
+
+    squ::execmulti(l, std::string("BEGIN IMMEDIATE"));
+
+    std::vector<std::future<int>> r;
+
+    for (auto const sql: {"INSERT INTO w VALUES(1)", "INSERT INTO w VALUES(2)",
+      "INSERT INTO w VALUES(3)", "INSERT OR ROLLBACK INTO w VALUES(2)",
+      "INSERT INTO w VALUES(4)", "INSERT INTO w VALUES(5)"})
+    {
+      r.push_back(db.exec_on(0, sql));
+    }
+
+    squ::execmulti(l, std::string("COMMIT"));
+
+    // however the writer happened to group them, what is left is what
+    // reported success
+    std::vector<int> k;
+
+    for (int i{}; i != 3; ++i)
+    {
+      auto const c(r[i].get());
+
+      CHECK((SQLITE_DONE == c) || (SQLITE_ABORT_ROLLBACK == c));
+
+      if (SQLITE_DONE == c)
+      {
+        k.push_back(i + 1);
+      }
+    }
+
+    CHECK(SQLITE_CONSTRAINT == (r[3].get() & 0xff));
+    CHECK(SQLITE_DONE == r[4].get());
+    CHECK(SQLITE_DONE == r[5].get());
+
+    k.insert(k.end(), {4, 5});
+
+    std::vector<int> v;
+
+    CHECK(SQLITE_DONE == db.gather(v, "SELECT k FROM w ORDER BY k"));
+    CHECK(k == v);
+  }
+
+  // a shard that cannot be opened is reported
+  {
+    squ::sharded_db db({files[0], "no/such/dir/sharded_db.db"});
+
+    CHECK(!db.ok());
+    CHECK(SQLITE_CANTOPEN == db.result());
+  }
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include "test.hpp"
+
+#if defined(__cpp_lib_span)
+int main()
+{
+  auto const db(open_memory());
+
+  std::int64_t const v[]{1, -2, 3, std::numeric_limits<std::int64_t>::min()};
+
+  // blobs bound statically are handed back where they are, at every offset
+  alignas(std::int64_t) unsigned char buf[sizeof(v) + alignof(std::int64_t)];
+
+  auto const s(squ::make_unique(db, "SELECT ?"));
+
+  std::size_t misaligned{};
+
+  for (std::size_t o{}; o != alignof(std::int64_t); ++o)
+  {
+    std::memcpy(buf + o, v, sizeof(v));
+
+    CHECK(SQLITE_ROW == squ::rexec(s,
+      squ::blobpair<squ::STATIC>{buf + o, sizeof(v)}));
+
+    auto const p(sqlite3_column_blob(s.get(), 0));
+
+    std::vector<std::int64_t> b;
+    auto const r(squ::get_span(s, 0, b));
+
+    if (reinterpret_cast<std::uintptr_t>(p) % alignof(std::int64_t))
+    {
+      ++misaligned;
+
+      CHECK(r.data() == b.data());
+    }
+    else
+    {
+      CHECK(r.data() == p);
+
+      // only then can the blob be viewed in place
+      CHECK(r.data() == squ::get<std::span<std::int64_t const>>(s, 0).data());
+    }
+
+    CHECK(std::equal(r.begin(), r.end(), std::begin(v), std::end(v)));
+  }
+
+  CHECK(alignof(std::int64_t) - 1 == misaligned);
+
+  // NULL is an empty span
+  {
+    CHECK(SQLITE_ROW == squ::rexec(s, nullptr));
+
+    std::vector<std::int64_t> b;
+
+    CHECK(squ::get_span(s, 0, b).empty());
+    CHECK(squ::get<std::span<std::int64_t const>>(s, 0).empty());
+  }
+
+  // prefetched rows copy blobs, aligned
+  std::memcpy(buf + 1, v, sizeof(v));
+
+  CHECK(SQLITE_OK == squ::rset(s,
+    squ::blobpair<squ::STATIC>{buf + 1, sizeof(v)}));
+
+  std::size_t n{};
+
+  for (auto& [r]: squ::prefetch_rows<std::span<std::int64_t const>>(s))
+  {
+    CHECK(!(reinterpret_cast<std::uintptr_t>(r.data()) %
+      alignof(std::int64_t)));
+    CHECK(std::equal(r.begin(), r.end(), std::begin(v), std::end(v)));
+
+    ++n;
+  }
+
+  CHECK(1 == n);
+
+  return 0;
+}
+#else
+int main()
+{
+  return 0;
+}
+#endif // __cpp_lib_span
@@ -0,0 +1,80 @@
+#include "test.hpp"
+
+using squ::detail::count_columns;
+using squ::detail::count_params;
+using squ::detail::unknown_count;
+
+// quotes and comments hide parameters, named ones count once, numbered ones
+// set the count
+static_assert(7 == count_params("SELECT ?, ?5, :a, :a, @b, '?', \"?\" -- ?\n"
+  " /* ? */ FROM t; SELECT ?"));
+static_assert(3 == count_params("SELECT ?2, ?"));
+static_assert(2 == count_params("INSERT INTO t VALUES(:x, :y, :x)"));
+static_assert(!count_params("SELECT 1"));
+
+static_assert(3 == count_columns("SELECT a, f(b, c), (SELECT 1, 2) FROM t "
+  "WHERE x IN (1, 2)"));
+static_assert(2 == count_columns("select distinct a,b from t"));
+static_assert(2 == count_columns("SELECT a*b, 2 * c"));
+static_assert(3 == count_columns("SELECT 'a,b', [c,d], 1.5e3 AS x"));
+static_assert(!count_columns("INSERT INTO t VALUES(1)"));
+static_assert(unknown_count == count_columns("SELECT * FROM t"));
+static_assert(unknown_count == count_columns("SELECT t.* FROM t"));
+static_assert(unknown_count == count_columns("DELETE FROM t RETURNING a"));
+static_assert(unknown_count == count_columns("PRAGMA user_version"));
+
+int main()
+{
+  auto const db(open_memory());
+
+  SQU_SQL("CREATE TABLE t(a, b)").exec(db);
+
+  // the counts agree with those sqlite determines
+  for (auto const s: {"SELECT ?, ?5, :a, :a, @b, '?', \"?\" -- ?\n"
+    " /* ? */ FROM t", "SELECT ?2, ?", "INSERT INTO t VALUES(:x, :y || :x)",
+    "SELECT a, (SELECT 1), b FROM t WHERE a IN (?, 2)",
+    "select distinct a,b from t", "SELECT a*b, 2 * b FROM t",
+    "SELECT 'a,b', [a], 1.5e3 AS x FROM t", "UPDATE t SET a = ?3",
+    "SELECT * FROM t"})
+  {
+    auto const p(squ::make_unique(db, s));
+    CHECK(p);
+
+    CHECK(count_params(s) == std::size_t(sqlite3_bind_parameter_count(
+      p.get())));
+
+    if (auto const c(count_columns(s)); unknown_count != c)
+    {
+      CHECK(c == std::size_t(sqlite3_column_count(p.get())));
+    }
+  }
+
+  constexpr auto ins(SQU_SQL("INSERT INTO t VALUES(?, ?)"));
+  static_assert((2 == ins.params) && !ins.columns);
+
+  CHECK(SQLITE_DONE == ins.exec(db, 1, "x"));
+  CHECK(SQLITE_DONE == ins.exec(db, 2, "y"));
+
+  std::string r;
+
+  CHECK(SQLITE_DONE == SQU_SQL("SELECT a, b FROM t WHERE a >= ?").foreach_row(
+    db, [&](int const a, std::string_view const b)
+    {
+      r.append(std::to_string(a)).append(b);
+    },
+    1
+  ));
+  CHECK("1x2y" == r);
+
+  CHECK("y" == SQU_SQL("SELECT b FROM t WHERE a = ?").execget<std::string>(db,
+    0, 2).value());
+
+  // where the counts are unknown, nothing is checked
+  CHECK(2 == SQU_SQL("SELECT * FROM t WHERE a = ?").execget<
+    std::pair<int, std::string>>(db, 0, 2).value().first);
+
+  auto const u(SQU_SQL("SELECT count(*) FROM t").unique(db));
+  CHECK(2 == squ::execget<int>(u).value());
+
+  return 0;
+}
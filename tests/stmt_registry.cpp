@@ -0,0 +1,87 @@
+#include "test.hpp"
+
+int main()
+{
+  std::remove("stmt_registry.db");
+
+  std::vector<squ::unique_db_t> dbs;
+
+  for (int i{}; i != 4; ++i)
+  {
+    dbs.push_back(squ::open_unique("stmt_registry.db",
+      SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE));
+  }
+
+  squ::execmulti(dbs[0], std::string(
+    "CREATE TABLE t(a INTEGER PRIMARY KEY, b TEXT)"));
+
+  squ::stmt_registry reg;
+
+  auto const get(reg.add("SELECT b FROM t WHERE a = ?"));
+  auto const sorted(reg.add("SELECT b FROM t ORDER BY b"));
+  auto const broken(reg.add("SELECT nope FROM t"));
+  auto const empty(reg.add(" -- nothing"));
+
+  CHECK(4 == reg.size());
+  CHECK("SELECT nope FROM t" == reg.sql(broken));
+
+  // failures and plan problems are reported, ordered by connection, per
+  // statement
+  {
+    auto const [stmts, problems](reg.warm(dbs));
+
+    CHECK(4 == stmts.size());
+    CHECK(8 == problems.size());
+
+    for (std::size_t c{}; c != stmts.size(); ++c)
+    {
+      CHECK(4 == stmts[c].size());
+
+      CHECK(stmts[c][get]);
+      CHECK(sqlite3_db_handle(stmts[c][get].get()) == dbs[c].get());
+      CHECK(stmts[c][sorted]);
+      CHECK(!stmts[c][broken]);
+      CHECK(!stmts[c][empty]);
+
+      auto& p(problems[2 * c]), & q(problems[2 * c + 1]);
+
+      CHECK((c == p.connection) && (sorted == p.id));
+      CHECK((SQLITE_OK == p.result) &&
+        ((squ::FULL_SCAN | squ::TEMP_BTREE) == p.plan));
+      CHECK((c == q.connection) && (broken == q.id));
+      CHECK((SQLITE_ERROR == q.result) && !q.plan);
+    }
+
+    // the statements are ready to use
+    squ::execmulti(dbs[0], std::string("INSERT INTO t VALUES(1, 'x')"));
+    CHECK("x" == squ::rexecget<std::string>(stmts[3][get], 0, 1).value());
+  }
+
+  // raw connections, and no connections at all
+  {
+    std::vector<sqlite3*> raw{dbs[0].get(), dbs[1].get()};
+
+    auto const [stmts, problems](reg.warm(raw.begin(), raw.end()));
+
+    CHECK((2 == stmts.size()) && (4 == problems.size()));
+    CHECK(1 == problems.back().connection);
+
+    CHECK(reg.warm(raw.begin(), raw.begin()).first.empty());
+  }
+
+  // or a single one, on the calling thread
+  {
+    std::vector<squ::warmup_problem> p;
+
+    auto const s(reg.prepare(dbs[2].get(), p, 7));
+
+    CHECK((4 == s.size()) && (2 == p.size()));
+    CHECK((7 == p[0].connection) && (7 == p[1].connection));
+  }
+
+  dbs.clear();
+
+  std::remove("stmt_registry.db");
+
+  return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef SQU_TEST_HPP
+# define SQU_TEST_HPP
+# pragma once
+
+#include <cstdio>
+
+#include <cstdlib>
+
+#include "sqliteutils.hpp"
+
+// tests are plain programs, a failed check ends them with a nonzero status
+#define CHECK(...)\
+  do\
+  {\
+    if (!(__VA_ARGS__))\
+    {\
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,\
+        #__VA_ARGS__);\
+      std::exit(1);\
+    }\
+  } while (false)
+
+inline auto open_memory()
+{
+  return squ::open_unique(":memory:",
+    SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+}
+
+#endif // SQU_TEST_HPP
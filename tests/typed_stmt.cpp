@@ -0,0 +1,109 @@
+#include "test.hpp"
+
+namespace
+{
+
+int reported;
+
+}
+
+int main()
+{
+  auto const db(open_memory());
+
+  squ::execmulti(db, std::string("CREATE TABLE t(a INTEGER, b TEXT, c REAL, "
+    "d, e NUMERIC, f BLOB);"
+    "INSERT INTO t VALUES(1, 'x', 1.5, 3, 1, x'01'),"
+    "(2, 'y', 2, 4, 2, x'02'), ('z', 'w', 3, 5, 3, x'03')"));
+
+  // declared types are checked once, on preparing
+  {
+    using row = std::tuple<int, std::string, double, std::string_view, int,
+      std::pair<int, double>>;
+
+    squ::typed_stmt<row> s(db, "SELECT a, b, c, d, e, a, c FROM t");
+
+    CHECK(s);
+    CHECK(-1 == s.mismatch());
+    CHECK(7 == s.columns);
+  }
+
+  // text does not fit a number, nor a real an integer, nor text a blob, and
+  // the column counts must agree
+  CHECK(0 == (squ::typed_stmt<std::pair<std::string, int>>(db,
+    "SELECT a, b FROM t")).mismatch());
+  CHECK(1 == (squ::typed_stmt<std::pair<int, double>>(db,
+    "SELECT a, b FROM t")).mismatch());
+  CHECK(0 == (squ::typed_stmt<int>(db, "SELECT c FROM t")).mismatch());
+  CHECK(0 == (squ::typed_stmt<squ::blobpair<>>(db, "SELECT b FROM t"))
+    .mismatch());
+  CHECK(1 == (squ::typed_stmt<std::pair<int, std::string>>(db,
+    "SELECT a FROM t")).mismatch());
+  CHECK(2 == (squ::typed_stmt<std::pair<int, std::string>>(db,
+    "SELECT a, b, c FROM t")).mismatch());
+
+  // an unprepared statement does not fit anything
+  CHECK(!squ::typed_stmt<int>());
+
+  // expressions have no declared type and are accepted
+  CHECK(squ::typed_stmt<std::pair<std::string, int>>(db,
+    "SELECT a || b, length(f) FROM t"));
+
+  // a debug statement reports every stored type differing from the
+  // expected one
+  {
+    using row = std::tuple<int, std::string, double, int>;
+
+    squ::typed_stmt<row, true> s(db, "SELECT a, b, c, d FROM t");
+    CHECK(s);
+
+    s.set_reporter([](sqlite3_stmt*, int const c, int const st,
+      int const e) noexcept
+      {
+        CHECK((0 == c) && (SQLITE_TEXT == st) && (SQLITE_INTEGER == e));
+
+        ++reported;
+      }
+    );
+
+    std::vector<row> v;
+
+    CHECK(SQLITE_DONE == s.foreach_row([&](row&& r) { v.push_back(r); }));
+    CHECK(3 == v.size());
+    CHECK(row(2, "y", 2., 4) == v[1]);
+    CHECK(1 == s.conversions());
+    CHECK(1 == reported);
+
+    // stopping early
+    CHECK(SQLITE_OK == s.reset());
+    CHECK(SQLITE_ROW == s.foreach_row([](row const&) noexcept
+      {
+        return true;
+      }
+    ));
+    CHECK(SQLITE_OK == s.reset());
+  }
+
+  // parameters and stepping row by row
+  {
+    squ::typed_stmt<std::pair<int, std::string>> s(db,
+      "SELECT a, b FROM t WHERE a >= ? ORDER BY a");
+
+    CHECK(SQLITE_OK == s.set(2));
+
+    std::pair<int, std::string> r;
+
+    CHECK(SQLITE_ROW == s.next(r));
+    CHECK(std::pair(2, std::string("y")) == r);
+    CHECK(SQLITE_ROW == s.next(r));
+    CHECK("w" == r.second);
+    CHECK(SQLITE_DONE == s.next(r));
+    CHECK("w" == r.second);
+
+    CHECK(SQLITE_OK == s.reset());
+    CHECK(SQLITE_ROW == s.next(r));
+    CHECK(2 == r.first);
+  }
+
+  return 0;
+}
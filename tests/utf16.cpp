@@ -0,0 +1,140 @@
+#include <random>
+
+#include "test.hpp"
+
+// random strings of ASCII runs, 2 and 3 byte sequences and surrogate pairs
+static std::u16string random_utf16(std::mt19937& g)
+{
+  std::u16string u;
+
+  for (auto n(g() % 300); n; --n)
+  {
+    switch (g() % 6)
+    {
+      case 0:
+        u.append(g() % 70, char16_t('a' + g() % 26));
+        break;
+
+      case 1:
+        u += char16_t(0x80 + g() % 0x780);
+        break;
+
+      case 2:
+        // skip the surrogates
+        u += char16_t(0x800 + g() % (0xd800 - 0x800));
+        break;
+
+      case 3:
+        // sqlite replaces the noncharacters U+FFFE and U+FFFF
+        u += char16_t(0xe000 + g() % 0x1ffe);
+        break;
+
+      case 4:
+      {
+        auto const c(g() % 0x100000);
+
+        u += char16_t(0xd800 + (c >> 10));
+        u += char16_t(0xdc00 + (c & 0x3ff));
+
+        break;
+      }
+
+      default:
+        u += char16_t(g() % 0x80);
+    }
+  }
+
+  return u;
+}
+
+int main()
+{
+  auto const db(open_memory());
+  auto const s(squ::make_unique(db, "SELECT ?"));
+
+  std::mt19937 g(42);
+
+  std::vector<char16_t> q;
+  std::vector<char> b;
+
+  // both directions agree with sqlite's own transcoding
+  for (int t{}; t != 20000; ++t)
+  {
+    auto const u(random_utf16(g));
+
+    b.resize(3 * u.size());
+    CHECK(SQLITE_OK == squ::set_utf16(s, u, b.data(), b.size()));
+    CHECK(SQLITE_ROW == squ::exec(s));
+
+    q.resize(squ::column_bytes(s, 0));
+    auto const r(squ::get_utf16(s, 0, q.data(), q.size()));
+    CHECK(SQLITE_OK == r.first);
+
+    std::u16string const v(q.data(), r.second);
+
+    auto const p(static_cast<char16_t const*>(sqlite3_column_text16(s.get(),
+      0)));
+    CHECK(std::u16string_view(p,
+      sqlite3_column_bytes16(s.get(), 0) / 2) == u);
+    CHECK(v == u);
+
+    squ::reset(s);
+  }
+
+  // too small an output buffer, at a vector boundary and in the scalar tail
+  {
+    std::string const a(100, 'a');
+
+    squ::set(s, a);
+    CHECK(SQLITE_ROW == squ::exec(s));
+
+    for (std::size_t m: {0, 1, 15, 16, 31, 32, 99})
+    {
+      q.resize(m + 1);
+      auto const r(squ::get_utf16(s, 0, q.data(), m));
+      CHECK((SQLITE_TOOBIG == r.first) && (r.second <= m));
+    }
+
+    squ::reset(s);
+  }
+
+  {
+    std::u16string const u(40, u'é');
+
+    b.resize(80);
+    CHECK(SQLITE_TOOBIG == squ::set_utf16(s, u, b.data(), 79));
+    CHECK(SQLITE_OK == squ::set_utf16(s, u, b.data(), 80));
+  }
+
+  // lone surrogates
+  for (auto const& u: {std::u16string(u"ab") + char16_t(0xd800),
+    std::u16string(1, char16_t(0xdc00)) + u"ab",
+    std::u16string(33, u'a') + char16_t(0xd800) + u"a"})
+  {
+    b.resize(3 * u.size());
+    CHECK(SQLITE_MISMATCH == squ::set_utf16(s, u, b.data(), b.size()));
+  }
+
+  // malformed UTF-8, overlong, truncated, surrogates and past U+10FFFF
+  for (auto const sv: {std::string_view("\xc0\x80"),
+    std::string_view("abc\xe2\x82"), std::string_view("\xed\xa0\x80"),
+    std::string_view("\xf4\x90\x80\x80"), std::string_view("\x80"),
+    std::string_view("0123456789abcdef0123456789abcdef\xff")})
+  {
+    squ::set(s, sv);
+    CHECK(SQLITE_ROW == squ::exec(s));
+
+    q.resize(64);
+    CHECK(SQLITE_MISMATCH == squ::get_utf16(s, 0, q.data(), q.size()).first);
+
+    squ::reset(s);
+  }
+
+  // NULL decodes as empty
+  squ::set(s, nullptr);
+  CHECK(SQLITE_ROW == squ::exec(s));
+  CHECK(std::pair<int, std::size_t>(SQLITE_OK, 0) ==
+    squ::get_utf16(s, 0, q.data(), q.size()));
+
+  return 0;
+}